@@ -193,14 +193,15 @@ struct DrawText_Test
     {
         auto r = rr.CreateCommandBuilder();
         std::string_view loremIpsum = "VA, Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat. Duis aute irure dolor in reprehenderit in voluptate velit esse cillum dolore eu fugiat nulla pariatur. Excepteur sint occaecat cupidatat non proident, sunt in culpa qui officia deserunt mollit anim id est laborum.";
+        TextDescription desc;
+        desc.fontName = fontName;
+        desc.fontSize = fontSize;
+        desc.renderOptions = renderOptions;
+        desc.foreground = color;
+
         float y = 0;
         for (int i = 0; i < 100; i++)
         {
-            TextDescription desc;
-            desc.fontName = fontName;
-            desc.fontSize = fontSize;
-            desc.renderOptions = renderOptions;
-            desc.foreground = color;
             r.DrawText(loremIpsum, 10, y, desc);
             y += fontSize * 1.5f;
         }
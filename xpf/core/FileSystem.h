@@ -1,9 +1,9 @@
 #pragma once
 #include <core/stringex.h>
 #include <core/Log.h>
+#include <core/MappedFile.h>
 #include <core/Types.h>
 
-#include <array>
 #include <functional>
 #include <fstream>
 #include <sstream>
@@ -47,28 +47,23 @@ public:
     }
 
     static std::vector<byte_t> LoadFile(xpf::string_viewex filename) {
-        // Log::info("Loading: " + filename);
         if (m_binary_callback != nullptr)
             return m_binary_callback(filename);
 
-        constexpr size_t c_readBufferSize = 4096;
-        std::ifstream stream(filename.data(), std::ios::binary | std::ios::in);
-        stream.exceptions(std::ios_base::badbit);
-
-        if (!stream.is_open())
-            return {};
+        return MappedFile::Read(filename);
+    }
 
-        std::vector<byte_t> result;
-        std::array<byte_t, c_readBufferSize> buffer;
-        while (stream.read(reinterpret_cast<char*>(buffer.data()), c_readBufferSize))
-        {
-            result.insert(result.end(), std::begin(buffer), std::begin(buffer) + stream.gcount());
+    // read-only bytes of the file without copying them where the platform can map files;
+    // nullptr if the file does not exist
+    static std::shared_ptr<const MappedFile> MapFile(xpf::string_viewex filename) {
+        if (m_binary_callback != nullptr) {
+            std::vector<byte_t> data = m_binary_callback(filename);
+            if (data.empty())
+                return nullptr;
+            return std::make_shared<const MappedFile>(std::move(data));
         }
 
-        result.insert(result.end(), std::begin(buffer), std::begin(buffer) + stream.gcount());
-        Log::info("Loaded: " + filename);
-
-        return result;
+        return MappedFile::Open(filename);
     }
 
     static std::string LoadTextFiles(std::initializer_list<std::string_view> files, bool useCallback = true) {
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <core/Time.h>
+
+namespace xpf {
+
+// Tracks whether the next frame needs to be rendered at all.
+// Anything that changes what is on screen (layout/visual invalidation, running tweens,
+// queued ui tasks, input, blinking carets) requests a frame; when nothing did, the app loop
+// can block on the platform event queue instead of calling Render().
+class FrameScheduler
+{
+protected:
+    static inline std::atomic<bool> m_frame_requested = true;
+    static inline std::mutex m_mutex;
+    static inline time_t m_next_frame_time = std::numeric_limits<time_t>::max();
+    static inline std::function<void()> m_wakeup = nullptr;
+
+public:
+    static constexpr time_t Infinite = std::numeric_limits<time_t>::max();
+
+    FrameScheduler() = delete;
+
+    // fn is called when a frame gets requested from any thread while the loop may be waiting
+    // (e.g. glfwPostEmptyEvent); it must be safe to call from worker threads.
+    static void SetWakeup(std::function<void()>&& fn)
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_wakeup = std::move(fn);
+    }
+
+    static void RequestFrame()
+    {
+        if (m_frame_requested.exchange(true))
+            return;
+
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (m_wakeup != nullptr)
+            m_wakeup();
+    }
+
+    // request a frame no later than the given time, e.g. the next caret blink
+    static void RequestFrameAt(time_t time)
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (time < m_next_frame_time)
+            m_next_frame_time = time;
+    }
+
+    static bool IsFrameRequested(time_t now)
+    {
+        if (m_frame_requested)
+            return true;
+
+        std::lock_guard<std::mutex> guard(m_mutex);
+        return now >= m_next_frame_time;
+    }
+
+    // seconds the loop may wait for events before the next timed frame is due, Infinite if none
+    static time_t GetWaitTimeout(time_t now)
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (m_next_frame_time == Infinite)
+            return Infinite;
+        return m_next_frame_time > now ? m_next_frame_time - now : 0;
+    }
+
+    // called by the app loop right before rendering; anything drawn in this frame that still
+    // needs another one (a playing tween, an invalidation during draw) requests it again
+    static void BeginFrame(time_t now)
+    {
+        m_frame_requested = false;
+
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (now >= m_next_frame_time)
+            m_next_frame_time = Infinite;
+    }
+};
+
+} // xpf
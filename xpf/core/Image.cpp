@@ -42,11 +42,21 @@ Image::Image(const std::vector<byte_t>& data, uint32_t width, uint32_t height, P
 
 /*static*/ Image Image::LoadImage(std::string_view filename)
 {
-    std::vector<byte_t> data = FileSystem::LoadFile(filename);
-    if (data.empty())
+    // the encoded bytes are only read once, decode straight from the mapped file
+    const std::shared_ptr<const MappedFile> spFile = FileSystem::MapFile(filename);
+    if (spFile == nullptr || spFile->empty())
         return Image();
 
-    return LoadImage(filename, data);
+    Image image;
+
+    // callback gets the first dibs, then the built-in parsers
+    if (s_imageParseCallback != nullptr)
+        image = s_imageParseCallback(filename, std::vector<byte_t>(spFile->data(), spFile->data() + spFile->size()));
+
+    if (image.IsEmpty())
+        image = Image::CreateImage(filename, spFile->data(), spFile->size());
+
+    return image;
 }
 
 /*static*/ Image Image::LoadImage(std::string_view filename, const std::vector<byte_t>& data)
@@ -58,7 +68,7 @@ Image::Image(const std::vector<byte_t>& data, uint32_t width, uint32_t height, P
         image = s_imageParseCallback(filename, data);
 
     if (image.IsEmpty())
-        image = Image::CreateImage(filename, data);
+        image = Image::CreateImage(filename, data.data(), data.size());
 
     return image;
 }
@@ -118,7 +128,7 @@ void Image::SaveImage(std::string_view filename, uint8_t quality)
     }
 }
 
-/*static*/ Image Image::CreateImage(std::string_view filename, const std::vector<byte_t>& dataIn)
+/*static*/ Image Image::CreateImage(std::string_view filename, const byte_t* pdataIn, size_t sizeIn)
 {
     int compressionLevel = 0;
     int width = 0;
@@ -130,8 +140,8 @@ void Image::SaveImage(std::string_view filename, uint8_t quality)
         ext == "png" || ext == "pic" || ext == "pgm" || ext == "psd" || ext == "tga")
     {
         const byte_t* pData = stbi_load_from_memory(
-            dataIn.data(),
-            static_cast<int>(dataIn.size()),
+            pdataIn,
+            static_cast<int>(sizeIn),
             &width,
             &height,
             &compressionLevel,
@@ -157,8 +167,8 @@ void Image::SaveImage(std::string_view filename, uint8_t quality)
     else if (ext == "hdr") 
     {
         const byte_t* pData = (const byte_t*)stbi_loadf_from_memory(
-            dataIn.data(),
-            static_cast<int>(dataIn.size()),
+            pdataIn,
+            static_cast<int>(sizeIn),
             &width,
             &height,
             &compressionLevel,
@@ -182,8 +192,8 @@ void Image::SaveImage(std::string_view filename, uint8_t quality)
     {
         qoi_desc desc = { 0, 0, 0, 0 };
         const byte_t* pData = (const byte_t*)qoi_decode(
-            (const void*)dataIn.data(),
-            static_cast<int>(dataIn.size()),
+            (const void*)pdataIn,
+            static_cast<int>(sizeIn),
             &desc,
             /*channels:*/ 4); // 4 channels RGBA
 
@@ -195,11 +205,13 @@ void Image::SaveImage(std::string_view filename, uint8_t quality)
         return Image(std::move(data), width, height, PixelFormat::R8G8B8A8, /*mipMapCount:*/ 1);
     }
     else if (ext == "svg" &&
-             dataIn.size() > 4 &&
-             dataIn[0] == '<' &&  dataIn[1] == 's' &&  dataIn[2] == 'v' && dataIn[3] == 'g' && dataIn[3] == ' ')
+             sizeIn > 4 &&
+             pdataIn[0] == '<' &&  pdataIn[1] == 's' &&  pdataIn[2] == 'v' && pdataIn[3] == 'g' && pdataIn[3] == ' ')
     {
         // <svg ...
-        NSVGimage* pSvg = nsvgParse((char*)(dataIn.data()), /*units:*/ "px", /*dpi:*/ 96.0f);
+        // nanosvg parses in place and wants a terminator, the input may be a read-only mapping
+        std::string text(reinterpret_cast<const char*>(pdataIn), sizeIn);
+        NSVGimage* pSvg = nsvgParse(text.data(), /*units:*/ "px", /*dpi:*/ 96.0f);
         std::vector<byte_t> data(pSvg->width * pSvg->height * 4);  // PixelFormat::R8G8B8A8 is 4 bytes
 
         NSVGrasterizer* pRasterizer = nsvgCreateRasterizer();
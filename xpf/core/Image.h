@@ -63,7 +63,7 @@ public:
 
     bool IsEmpty() const { return m_data.empty(); }
 
-    const std::vector<byte_t> GetData() const { return m_data; }
+    const std::vector<byte_t>& GetData() const { return m_data; }
     uint32_t GetWidth() const { return m_width; }
     uint32_t GetHeight() const { return m_height; }
     uint32_t GetMipMapCount() const { return m_mipMapCount; }
@@ -75,7 +75,7 @@ public:
     Image Resize(uint32_t width, uint32_t height);
 
 protected:
-    static Image CreateImage(std::string_view filename, const std::vector<byte_t>& data);
+    static Image CreateImage(std::string_view filename, const byte_t* pdata, size_t size);
     uint8_t GetBytesPerPixel() const;
     size_t GetImageDataDize() const;
     std::tuple<uint32_t, uint32_t, uint32_t> GetOpenGLTextureFormats() const;
@@ -1,5 +1,6 @@
 #pragma once
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -11,11 +12,12 @@ public:
 
 private:
     static inline std::vector<std::string> s_log;
+    static inline std::mutex s_mutex; // fonts load on worker threads and log from there
 
 public:
     static void Assert(bool condition, std::string_view str) { if (!condition) error(str); }
-    static void info(std::string_view str) { s_log.emplace_back(str); if (report_to_cout) std::cout << "info: " << str << std::endl; }
-    static void error(std::string_view str) { s_log.emplace_back(str); if (report_to_cout) std::cout << "error: " << str << std::endl; }
+    static void info(std::string_view str) { std::lock_guard<std::mutex> lock(s_mutex); s_log.emplace_back(str); if (report_to_cout) std::cout << "info: " << str << std::endl; }
+    static void error(std::string_view str) { std::lock_guard<std::mutex> lock(s_mutex); s_log.emplace_back(str); if (report_to_cout) std::cout << "error: " << str << std::endl; }
 };
 
 } // xpf
\ No newline at end of file
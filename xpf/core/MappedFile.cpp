@@ -0,0 +1,117 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <string>
+
+#if defined(PLATFORM_WINDOWS)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace xpf {
+
+MappedFile::MappedFile(std::vector<byte_t>&& data)
+    : m_buffer(std::move(data))
+{
+    m_pdata = m_buffer.data();
+    m_size = m_buffer.size();
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_pmapping == nullptr)
+        return;
+
+#if defined(PLATFORM_WINDOWS)
+    ::UnmapViewOfFile(m_pmapping);
+    ::CloseHandle(m_hmapping);
+#else
+    ::munmap(m_pmapping, m_size);
+#endif
+}
+
+/*static*/ std::shared_ptr<const MappedFile> MappedFile::Open(std::string_view filenameIn)
+{
+    const std::string filename(filenameIn);
+    auto spFile = std::make_shared<MappedFile>();
+
+#if defined(PLATFORM_WINDOWS)
+    HANDLE hfile = ::CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hfile == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    LARGE_INTEGER fileSize{};
+    if (::GetFileSizeEx(hfile, &fileSize) && fileSize.QuadPart > 0)
+    {
+        // the mapping keeps the file open, the handle can go
+        HANDLE hmapping = ::CreateFileMappingA(hfile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (hmapping != nullptr)
+        {
+            void* pview = ::MapViewOfFile(hmapping, FILE_MAP_READ, 0, 0, 0);
+            if (pview != nullptr)
+            {
+                spFile->m_pmapping = pview;
+                spFile->m_hmapping = hmapping;
+                spFile->m_pdata = static_cast<const byte_t*>(pview);
+                spFile->m_size = size_t(fileSize.QuadPart);
+            }
+            else
+            {
+                ::CloseHandle(hmapping);
+            }
+        }
+    }
+    ::CloseHandle(hfile);
+#else
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat info{};
+    if (::fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        void* pmapping = ::mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (pmapping != MAP_FAILED)
+        {
+            spFile->m_pmapping = pmapping;
+            spFile->m_pdata = static_cast<const byte_t*>(pmapping);
+            spFile->m_size = size_t(info.st_size);
+        }
+    }
+    ::close(fd);
+#endif
+
+    if (spFile->m_pmapping == nullptr)
+    {
+        // empty files and file systems that cannot map
+        spFile->m_buffer = Read(filename);
+        spFile->m_pdata = spFile->m_buffer.data();
+        spFile->m_size = spFile->m_buffer.size();
+    }
+
+    return spFile;
+}
+
+/*static*/ std::vector<byte_t> MappedFile::Read(std::string_view filename)
+{
+    std::ifstream stream(std::string(filename), std::ios::binary | std::ios::in | std::ios::ate);
+    if (!stream.is_open())
+        return {};
+
+    const std::streamoff size = stream.tellg();
+    if (size <= 0)
+        return {};
+
+    std::vector<byte_t> result(static_cast<size_t>(size));
+    stream.seekg(0);
+    if (!stream.read(reinterpret_cast<char*>(result.data()), size))
+        result.resize(static_cast<size_t>(stream.gcount()));
+
+    return result;
+}
+
+} // xpf
@@ -0,0 +1,44 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <core/Types.h>
+
+namespace xpf {
+
+// Read-only bytes of a file. The file is memory mapped where the platform allows it,
+// otherwise read with a single allocation sized from the file; either way the bytes
+// stay valid for as long as the MappedFile lives.
+class MappedFile
+{
+protected:
+    const byte_t* m_pdata = nullptr;
+    size_t m_size = 0;
+    std::vector<byte_t> m_buffer; // data that was read or handed in rather than mapped
+    void* m_pmapping = nullptr;   // platform mapping, null when not mapped
+#if defined(PLATFORM_WINDOWS)
+    void* m_hmapping = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    explicit MappedFile(std::vector<byte_t>&& data);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    // nullptr if the file cannot be opened
+    static std::shared_ptr<const MappedFile> Open(std::string_view filename);
+
+    // reads the whole file with one allocation, empty if it cannot be opened
+    static std::vector<byte_t> Read(std::string_view filename);
+
+    std::span<const byte_t> GetSpan() const { return {m_pdata, m_size}; }
+    const byte_t* data() const { return m_pdata; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    bool IsMapped() const { return m_pmapping != nullptr; }
+};
+
+} // xpf
@@ -5,6 +5,7 @@
 #include <stack>
 #include <thread>
 #include <core/Event.h>
+#include <core/FrameScheduler.h>
 #include <core/Log.h>
 
 namespace xpf {
@@ -66,6 +67,7 @@ public:
         std::unique_lock<std::mutex> lock(m_ui_mutex);
         m_ui_tasks.push(std::move(fn));
         m_ui_taskcount++;
+        FrameScheduler::RequestFrame();
     }
 
     void RunUITasks() {
@@ -4,6 +4,7 @@
 #include <thread>
 #include <unordered_set>
 #include <math/xpfmath.h>
+#include <core/FrameScheduler.h>
 #include <core/StackGuard.h>
 #include <core/Time.h>
 
@@ -215,6 +216,7 @@ public:
             m_forward = forward;
             m_state = state::Playing;
         }
+        FrameScheduler::RequestFrame();
         return *this;
     }
 
@@ -226,6 +228,10 @@ public:
         if (m_state == state::Stopped)
             return m_lastValue;
 
+        // a playing tween is read every frame, keep them coming until it stops
+        if (m_state == state::Playing)
+            FrameScheduler::RequestFrame();
+
         const double time = m_state == state::Paused
             ? m_pauseTime
             : Time::GetTime();
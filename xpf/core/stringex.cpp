@@ -1,7 +1,16 @@
 #include "stringex.h"
 #include <algorithm>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define XPF_UTF8_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define XPF_UTF8_NEON
+#endif
 //#include "hash.h"
 
 namespace xpf {
@@ -16,6 +25,64 @@ static bool string_viewex_equals_ch(char ch1, char ch2) {
 static bool string_viewex_equals_chi(char ch1, char ch2) {
     return std::tolower(ch1) == std::tolower(ch2);
 }
+
+// true when all 16 bytes at p are ASCII and none of them is '\0'
+static inline bool utf8_is_ascii_block(const char* p) {
+#if defined(XPF_UTF8_SSE2)
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const int nonAscii = _mm_movemask_epi8(v);
+    const int zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+    return (nonAscii | zeros) == 0;
+#elif defined(XPF_UTF8_NEON)
+    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    return vmaxvq_u8(v) < 0x80 && vminvq_u8(v) != 0;
+#else
+    constexpr uint64_t highBits = 0x8080808080808080ull;
+    constexpr uint64_t lowBits = 0x0101010101010101ull;
+    uint64_t a, b;
+    std::memcpy(&a, p, 8);
+    std::memcpy(&b, p + 8, 8);
+    auto hasZero = [](uint64_t x) { return ((x - lowBits) & ~x & highBits) != 0; };
+    return ((a | b) & highBits) == 0 && !hasZero(a) && !hasZero(b);
+#endif
+}
+
+// decodes the multi byte sequence at text[i], rejecting overlong forms, surrogates,
+// values past U+10FFFF and truncated sequences; those consume one byte and yield U+FFFD
+static inline char32_t utf8_decode_validated(const uint8_t* p, size_t length, size_t& i) {
+    constexpr char32_t replacement = 0xFFFD;
+    auto isContinuation = [](uint8_t b) { return (b & 0b11000000) == 0b10000000; };
+
+    const uint8_t b0 = p[i];
+    if (b0 >= 0xC2 && b0 <= 0xDF) {
+        if (i + 1 < length && isContinuation(p[i + 1])) {
+            const char32_t ch = char32_t(b0 & 0b00011111) << 6 | (p[i + 1] & 0b00111111);
+            i += 2;
+            return ch;
+        }
+    }
+    else if (b0 >= 0xE0 && b0 <= 0xEF) {
+        const uint8_t lo = b0 == 0xE0 ? 0xA0 : 0x80;
+        const uint8_t hi = b0 == 0xED ? 0x9F : 0xBF;
+        if (i + 2 < length && p[i + 1] >= lo && p[i + 1] <= hi && isContinuation(p[i + 2])) {
+            const char32_t ch = char32_t(b0 & 0b00001111) << 12 | char32_t(p[i + 1] & 0b00111111) << 6 | (p[i + 2] & 0b00111111);
+            i += 3;
+            return ch;
+        }
+    }
+    else if (b0 >= 0xF0 && b0 <= 0xF4) {
+        const uint8_t lo = b0 == 0xF0 ? 0x90 : 0x80;
+        const uint8_t hi = b0 == 0xF4 ? 0x8F : 0xBF;
+        if (i + 3 < length && p[i + 1] >= lo && p[i + 1] <= hi && isContinuation(p[i + 2]) && isContinuation(p[i + 3])) {
+            const char32_t ch = char32_t(b0 & 0b00000111) << 18 | char32_t(p[i + 1] & 0b00111111) << 12 | char32_t(p[i + 2] & 0b00111111) << 6 | (p[i + 3] & 0b00111111);
+            i += 4;
+            return ch;
+        }
+    }
+
+    i += 1;
+    return replacement;
+}
 #pragma endregion
 
 #pragma region xpf::string_viewex
@@ -211,40 +278,71 @@ stringex stringex::to_lower() {
 }
 
 /*static*/ char32_t stringex::utf8_to_utf32(std::string_view text, size_t& i) {
-    char32_t ch = 0;
+    if (i >= text.size())
+        return 0;
 
-    if (i < text.size() && (text[i] & 0b10000000) == 0) {
-        // 1 byte code point, ASCII
-        ch = text[i];
-        i += 1;
-    }
-    else if (i + 1 < text.size() && (text[i] & 0b11100000) == 0b11000000) {
-        // 2 byte code point
-        ch = (uint32_t(text[i]) & 0b00011111) << 6 | (uint32_t(text[i + 1]) & 0b00111111);
-        i += 2;
-    }
-    else if (i + 2 < text.size() && (text[i] & 0b11110000) == 0b11100000) {
-        // 3 byte code point
-        ch = (uint32_t(text[i]) & 0b00001111) << 12 | (uint32_t(text[i + 1]) & 0b00111111) << 6 | (uint32_t(text[i + 2]) & 0b00111111);
-        i += 3;
-    }
-    else if (i + 3 < text.size()) {
-        // 4 byte code point
-        ch = (uint32_t(text[i]) & 0b00000111) << 18 | (uint32_t(text[i + 1]) & 0b00111111) << 12 | (uint32_t(text[i + 2]) & 0b00111111) << 6 | (uint32_t(text[i + 3]) & 0b00111111);
-        i += 4;
+    // same validation as the bulk decoder, so every path sees the same codepoints
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(text.data());
+    if (p[i] < 0x80) [[likely]]
+        return p[i++];
+
+    return utf8_decode_validated(p, text.size(), i);
+}
+
+/*static*/ size_t stringex::utf8_to_utf32(std::string_view text, std::vector<char32_t>& out) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(text.data());
+    const size_t length = text.length();
+
+    // never more codepoints than bytes
+    out.resize(length);
+    char32_t* pout = out.data();
+    size_t count = 0;
+    size_t i = 0;
+    while (i < length) {
+        if (i + 16 <= length && utf8_is_ascii_block(text.data() + i)) [[likely]] {
+            for (size_t k = 0; k < 16; k++)
+                pout[count + k] = p[i + k];
+            i += 16;
+            count += 16;
+            continue;
+        }
+
+        const uint8_t b0 = p[i];
+        if (b0 < 0x80) [[likely]] {
+            if (b0 == 0) [[unlikely]]
+                break;
+            pout[count++] = b0;
+            i++;
+        } else {
+            pout[count++] = utf8_decode_validated(p, length, i);
+        }
     }
 
-    return ch;
+    out.resize(count);
+    return count;
 }
 
 /*static*/ uint32_t stringex::get_char_count(std::string_view text) {
-    size_t i = 0;
-    size_t txtlen = text.length();
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(text.data());
+    const size_t length = text.length();
     uint32_t count = 0;
-    while (i < txtlen) {
-        const uint32_t ch = stringex::utf8_to_utf32(text, i);
-        if (ch == 0) [[unlikely]]
-            break;
+    size_t i = 0;
+    while (i < length) {
+        if (i + 16 <= length && utf8_is_ascii_block(text.data() + i)) [[likely]] {
+            i += 16;
+            count += 16;
+            continue;
+        }
+
+        const uint8_t b0 = p[i];
+        if (b0 < 0x80) [[likely]] {
+            if (b0 == 0) [[unlikely]]
+                break;
+            i++;
+        } else {
+            utf8_decode_validated(p, length, i);
+        }
+
         count++;
     }
 
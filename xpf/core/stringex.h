@@ -55,7 +55,10 @@ public:
 
     stringex to_lower();
 
+    // decodes the codepoint at text[i] and moves i past it, a malformed byte becomes U+FFFD; 0 at the end
     static char32_t utf8_to_utf32(std::string_view text, size_t& i);
+    // decodes the whole text (up to the first '\0') into out, malformed sequences become U+FFFD
+    static size_t utf8_to_utf32(std::string_view text, std::vector<char32_t>& out);
     static uint32_t get_char_count(std::string_view text);
 
     void append32(char32_t ch32);
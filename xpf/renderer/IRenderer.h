@@ -36,6 +36,7 @@ enum class RendererCapability : uint64_t
     Default = 0x0,
     ShaderRenderedText = 0x1,
     ShaderInstancedRenderedText = 0x2,
+    InstancedTexturedText = 0x4, // atlas textured glyphs drawn as instances of one quad, see RenderTextInstancesCommand
 };
 
 ENUM_CLASS_FLAG_OPERATORS(RendererCapability);
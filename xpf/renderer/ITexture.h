@@ -34,6 +34,9 @@ public:
     virtual std::shared_ptr<ITexture> SampledTexture(Interpolation interpolation, rectf_t region = {0,0,1,1}) const = 0;
     virtual void SetRegion(rectf_t region) = 0;
 
+    // overwrites the pixels in region (in texels) with data laid out rowLength pixels apart
+    virtual void UpdatePixels(recti_t region, const byte_t* pdata, uint32_t rowLength) = 0;
+
     static inline std::function<
         std::shared_ptr<ITexture>(
             std::vector<byte_t>&& data,
@@ -24,6 +24,8 @@ enum class RenderCommandId
     glyph,
     glyphs,
     rounded_rectangle_with_border_dots,
+    text_distance_field,
+    text_instanced,
     // transform should be last
     transform,
     clip,
@@ -191,6 +193,35 @@ struct RenderGlyphsCommand : public RenderDrawCommand
     {}
 };
 
+struct RenderTextInstancesCommand : public RenderDrawCommand
+{
+#pragma pack(push)
+#pragma pack(1)
+    // one atlas textured glyph; the renderer expands it from a shared unit quad
+    struct GlyphInstance
+    {
+        float left, top;
+        uint16_t width, height;  // in 1/c_sizeScale pixels
+        uint16_t u0, v0, u1, v1; // normalized to 0..65535
+        uint8_t r, g, b, a;
+    };
+#pragma pack(pop)
+
+    static constexpr float c_sizeScale = 16.0f;
+
+    std::vector<GlyphInstance> instances;
+    RenderCommandId glyphCommandId; // text or text_distance_field, picks the fragment shading
+
+    RenderTextInstancesCommand(
+        RenderCommandId glyphCommandIdIn,
+        std::vector<GlyphInstance>&& instancesIn,
+        const std::shared_ptr<ITexture>& spTextureIn)
+        : RenderDrawCommand(RenderCommandId::text_instanced, {}, uint32_t(instancesIn.size()), spTextureIn)
+        , instances(std::move(instancesIn))
+        , glyphCommandId(glyphCommandIdIn)
+    {}
+};
+
 struct RenderCallbackCommand : public RenderCommand
 {
     std::function<RenderBatch()> fn;
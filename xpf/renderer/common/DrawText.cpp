@@ -2,6 +2,7 @@
 #include "Font.h"
 #include "Glyph.h"
 #include "FormattedText.h"
+#include "TextLayoutCache.h"
 #include <renderer/IBuffer.h>
 
 namespace xpf {
@@ -59,13 +60,29 @@ rectf_t RenderBatchBuilder::DrawText(std::string_view text, float x, float y, co
     float xorg = x;
     float yorg = y;
 
-    Typeface typeface;
-    typeface.name = description.fontName;
-    typeface.size = description.fontSize;
-    typeface.index = description.fontIndex;
-    typeface.renderOptions = description.renderOptions;
-    bool lineShaded = typeface.renderOptions & FontRenderOptions::Shaded;
-    bool triShaded = typeface.renderOptions & FontRenderOptions::ShadedByTris;
+    const bool instancedText = UsesInstancedText();
+    auto pushGlyphQuad = [this, instancedText](const std::shared_ptr<ITexture>& spTexture, RenderCommandId commandId, const rectf_t& position, const rectf_t& texCoords, v4_t tint)
+    {
+        if (instancedText)
+            return PushTextInstance(spTexture, commandId, position, texCoords, tint);
+
+        if (m_spTexture != spTexture || m_commandId != commandId || m_vertices.size() > 8000)
+        {
+            Flush();
+            m_commandId = commandId;
+            m_spTexture = spTexture;
+        }
+
+        PushQuad(
+            {position.top_left(), tint, texCoords.top_left() },
+            {position.top_right(), tint, texCoords.top_right() },
+            {position.bottom_right(), tint, texCoords.bottom_right() },
+            {position.bottom_left(), tint, texCoords.bottom_left() });
+    };
+
+    FontRenderOptions renderOptions = description.renderOptions;
+    bool lineShaded = renderOptions & FontRenderOptions::Shaded;
+    bool triShaded = renderOptions & FontRenderOptions::ShadedByTris;
     bool shaded = lineShaded || triShaded;
     v4_t tint = description.foreground.get_vec4();
 
@@ -77,12 +94,42 @@ rectf_t RenderBatchBuilder::DrawText(std::string_view text, float x, float y, co
         {
             shaded = lineShaded = triShaded = false;
             instanced = rendered = false;
-            typeface.renderOptions &= ~FontRenderOptions::Shaded;
+            renderOptions &= ~FontRenderOptions::Shaded;
         }
     }
 
-    auto spFont = Font::GetFont(typeface);
-    typeface = spFont->GetTypeface();
+    if (!shaded)
+    {
+        if (const TextLayout* pLayout = TextLayoutCache::Find(text, description))
+        {
+            const rectf_t& bounds = pLayout->bounds;
+            if (!description.background.is_transparent())
+                DrawRectangle(xorg + bounds.x, yorg + bounds.y, bounds.w, bounds.h, description.background);
+
+            for (const auto& quad : pLayout->quads)
+            {
+                const rectf_t position{xorg + quad.position.x, yorg + quad.position.y, quad.position.w, quad.position.h};
+                pushGlyphQuad(quad.spTexture, pLayout->commandId, position, quad.texCoords, tint);
+            }
+
+            return {xorg, yorg, bounds.w, bounds.h};
+        }
+    }
+
+    {
+        // the cached id is kept only while it still names the fields, a description
+        // that was edited after its first draw gets resolved again
+        Typeface requested;
+        requested.name = description.fontName;
+        requested.size = description.fontSize;
+        requested.index = description.fontIndex;
+        requested.renderOptions = renderOptions;
+        if (description.typefaceId == TypefaceId::NotSet || Font::GetTypeface(description.typefaceId) != requested)
+            description.typefaceId = Font::GetTypefaceId(requested);
+    }
+
+    auto spFont = Font::GetFont(description.typefaceId);
+    const Typeface& typeface = spFont->GetTypeface();
     const auto& metrics = spFont->GetMetrics();
     const float baseline = metrics.baseline;
     const float lineHeight = metrics.lineHeight;
@@ -176,24 +223,32 @@ rectf_t RenderBatchBuilder::DrawText(std::string_view text, float x, float y, co
     }
     else
     {
-        DrawTextImpl(text, spFont, description.fontSize, x, y, [&](float left, float top, float right, float bottom, const CodepointPage& page, const Codepoint& cp)
+        // distance field bitmaps carry extra pixels around the glyph outline
+        const RenderCommandId commandId = spFont->IsDistanceField() ? RenderCommandId::text_distance_field : RenderCommandId::text;
+        const float padding = spFont->GetGlyphPadding() * scale;
+
+        // remember the quads relative to x,y so the next call with the same text only translates them
+        TextLayout* pLayout = TextLayoutCache::Add(text, description);
+        if (pLayout != nullptr)
         {
-            if (m_spTexture != page.spTexture || m_vertices.size() > 8000)
-            {
-                Flush();
-                m_commandId = RenderCommandId::text;
-                m_spTexture = page.spTexture;
-            }
+            pLayout->bounds = {x - xorg, y - yorg, bounds.width, bounds.height};
+            pLayout->commandId = commandId;
+        }
+
+        DrawTextImpl(text, spFont, description.fontSize, x, y, [&](float left, float top, float /*right*/, float /*bottom*/, const CodepointPage& page, const Codepoint& cp)
+        {
+            const std::shared_ptr<ITexture>& spTexture = Font::GetTexture(page, cp);
+            if (spTexture == nullptr) [[unlikely]]
+                return;
 
+            left -= padding;
             top += (baseline + cp.yoffset) * scale;
-            right = left + cp.width * scale;
-            bottom = (top + cp.height * scale);
+            const rectf_t position{left, top, cp.width * scale, cp.height * scale};
+            const rectf_t texCoords = Font::GetTexCoords(cp);
+            pushGlyphQuad(spTexture, commandId, position, texCoords, tint);
 
-            PushQuad(
-                {{left,  top}, tint, cp.texCoords.top_left() },
-                {{right, top}, tint, cp.texCoords.top_right() },
-                {{right, bottom}, tint, cp.texCoords.bottom_right() },
-                {{left,  bottom}, tint, cp.texCoords.bottom_left() });
+            if (pLayout != nullptr)
+                pLayout->quads.push_back({{left - xorg, top - yorg, position.w, position.h}, texCoords, spTexture, cp.atlasSlot});
         });
     }
 
@@ -202,52 +257,71 @@ rectf_t RenderBatchBuilder::DrawText(std::string_view text, float x, float y, co
 
 void RenderBatchBuilder::DrawText(float x, float y, FormattedText& ft, xpf::Color color)
 {
-    if (m_commandId != RenderCommandId::text)
+    const auto& lines = ft.GetLines();
+    const RenderCommandId commandId = ft.IsDistanceField() ? RenderCommandId::text_distance_field : RenderCommandId::text;
+    if (m_commandId != commandId)
         Flush();
 
-    m_commandId = RenderCommandId::text;
+    m_commandId = commandId;
     const float xorg = x;
     const float baseline = ft.GetBaseline();
+    const float padding = ft.GetGlyphPadding();
+    const bool instancedText = UsesInstancedText();
     v4_t tint = color.get_vec4();
 
-    auto renderGlyph = [this, baseline, tint](const Glyph& g, float xGlyph, float yGlyph)
-    {
-        if (g.width != 0)
-        {
-            if (m_spTexture != g.spTexture || m_vertices.size() > 8000)
-            {
-                Flush();
-                m_spTexture = g.spTexture;
-                m_commandId = RenderCommandId::text;
-            }
-
-            float left  = (xGlyph + g.bearing_x);
-            float top   = yGlyph + baseline + g.yoffset;
-            float right = left + g.width;
-            float bottom = top + g.height;
-
-            PushQuad(
-                {{left,  top}, tint, g.texture_coordinates.top_left() },
-                {{right, top}, tint, g.texture_coordinates.top_right() },
-                {{right, bottom}, tint, g.texture_coordinates.bottom_right() },
-                {{left,  bottom}, tint, g.texture_coordinates.bottom_left() });
-        }
-
-        return g.advance_to_right(xGlyph);
-    };
-
-    for (const auto& line : ft.GetLines())
+    for (const auto& line : lines)
     {
         if (line.isOverBudgetY)
             break;
 
         x = xorg;
-        for (const auto& g : line.glyphs)
+        for (const GlyphRun& run : line.runs)
         {
-            if (g.is_newline())
-                break;
+            // one texture switch and one reference per run, not per glyph
+            const bool hasTexture = run.spTexture != nullptr;
+            if (hasTexture && !instancedText && m_spTexture != run.spTexture)
+            {
+                Flush();
+                m_spTexture = run.spTexture;
+                m_commandId = commandId;
+            }
 
-            x = renderGlyph(g, x, y);
+            const Glyph* pglyph = line.glyphs.data() + run.firstGlyph;
+            const Glyph* pend = pglyph + run.glyphCount;
+            for (; pglyph != pend; pglyph++)
+            {
+                const Glyph& g = *pglyph;
+                if (g.is_newline())
+                    break;
+
+                if (hasTexture && g.width != 0 && instancedText)
+                {
+                    const rectf_t position{x + g.bearing_x - padding, y + baseline + g.yoffset, g.width, g.height};
+                    PushTextInstance(run.spTexture, commandId, position, g.texture_coordinates, tint);
+                }
+                else if (hasTexture && g.width != 0)
+                {
+                    if (m_vertices.size() > 8000) [[unlikely]]
+                    {
+                        Flush();
+                        m_spTexture = run.spTexture;
+                        m_commandId = commandId;
+                    }
+
+                    float left  = (x + g.bearing_x - padding);
+                    float top   = y + baseline + g.yoffset;
+                    float right = left + g.width;
+                    float bottom = top + g.height;
+
+                    PushQuad(
+                        {{left,  top}, tint, g.texture_coordinates.top_left() },
+                        {{right, top}, tint, g.texture_coordinates.top_right() },
+                        {{right, bottom}, tint, g.texture_coordinates.bottom_right() },
+                        {{left,  bottom}, tint, g.texture_coordinates.bottom_left() });
+                }
+
+                x = g.advance_to_right(x);
+            }
         }
 
         y = ft.AdvanceToNewline(y);
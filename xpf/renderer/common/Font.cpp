@@ -1,4 +1,5 @@
 #include <renderer/common/Font.h>
+#include <renderer/common/FontLoader.h>
 #include <renderer/IBuffer.h>
 #include <renderer/ITexture.h>
 #include <core/FileSystem.h>
@@ -194,6 +195,7 @@ static void stbtt_tesselate_cubic(std::vector<short>& points, float x0, float y0
 struct FontInfo
 {
     stbtt_fontinfo info;
+    std::shared_ptr<const MappedFile> spFile; // info points into it
     bool supportsLineShading = false;
     bool supportsTriShading = false;
     bool supportsTextureShading = true;
@@ -212,124 +214,237 @@ float Font::GetScale(int16_t fontSize) const
     return ((m_typeface.size == 0) ? 1.0 : fontSize / float(m_typeface.size));
 }
 
+// scratch for decoded text, callers take it by move so nested use just allocates
+static thread_local std::vector<char32_t> s_decodedText;
+
+struct ResolvedCodepoint
+{
+    CodepointPage* ppage = nullptr;
+    const Codepoint* pcodepoint = nullptr;
+    bool isMissing = false;
+};
+static thread_local std::vector<ResolvedCodepoint> s_resolvedText;
+static thread_local std::vector<std::pair<CodepointPage*, Codepoint*>> s_pendingShapes;
+
 void Font::ForEachCodepoint(std::string_view text, std::function<void(char32_t, const CodepointPage&, const Codepoint&, float)>&& fn)
 {
-    uint32_t currentPageIndex = m_isDefaultFont ? 0 : std::numeric_limits<uint32_t>::max();
-    auto pageIter = m_isDefaultFont ? m_pages.cbegin() : m_pages.cend();
-    const size_t length = text.length();
+    uint32_t currentPageIndex = std::numeric_limits<uint32_t>::max();
+    CodepointPage* pcurrentPage = nullptr;
     uint32_t prevGlyphIndex = 0;
     const float scaler = (m_typeface.renderOptions & FontRenderOptions::Shaded || m_typeface.renderOptions & FontRenderOptions::ShadedByTris) ? 1.0 : m_scale;
 
-    size_t i = 0;
-    while (i < length) {
-        const uint32_t ch = stringex::utf8_to_utf32(text, i);
-        if (ch == 0) [[unlikely]]
-            break;
-        else if (ch == '\n') [[unlikely]]
-             prevGlyphIndex = 0;
-
-        const uint32_t pageIndex = uint32_t(ch / m_pageSize);
-        if (pageIndex != currentPageIndex) [[unlikely]] {
-            if (m_isDefaultFont) [[unlikely]] {
-                auto questionMark = GetCodepoint(m_typeface.defaultCharacter);
-                fn(ch, questionMark.first, questionMark.second, 0);
-                continue;
-            }
-
-            pageIter = m_pages.find(pageIndex);
-            if (pageIter == m_pages.cend()) [[unlikely]] {
-                m_pages[pageIndex] = LoadPage(pageIndex);
-                pageIter = m_pages.find(pageIndex);
+    std::vector<char32_t> decoded = std::move(s_decodedText);
+    std::vector<ResolvedCodepoint> resolved = std::move(s_resolvedText);
+    std::vector<std::pair<CodepointPage*, Codepoint*>> shapes = std::move(s_pendingShapes);
+    stringex::utf8_to_utf32(text, decoded);
+    resolved.resize(decoded.size());
+    shapes.clear();
+
+    // first pass builds every glyph the text needs, so a page buffer is
+    // recreated at most once before fn gets to see it
+    for (size_t i = 0; i < decoded.size(); i++) {
+        const char32_t ch = decoded[i];
+        CodepointPage* ppage = nullptr;
+        uint32_t codepointIndex = ch;
+        if (ch < c_asciiRange && m_pAsciiPage != nullptr) [[likely]] {
+            ppage = m_pAsciiPage;
+        } else {
+            const uint32_t pageIndex = uint32_t(ch / m_pageSize);
+            if (pageIndex != currentPageIndex) [[unlikely]] {
+                pcurrentPage = FindPage(pageIndex);
+                currentPageIndex = pageIndex;
             }
 
-            currentPageIndex = pageIndex;
+            ppage = pcurrentPage;
+            codepointIndex = ch % m_pageSize;
         }
 
-        const CodepointPage& page = pageIter->second;
-        const uint32_t codepointIndex = ch % m_pageSize;
-
-        const auto codepointIter = page.codepoints.find(codepointIndex);
-        if (codepointIter == page.codepoints.cend()) [[unlikely]] {
+        Codepoint* pcodepoint = ppage != nullptr ? ppage->Find(codepointIndex) : nullptr;
+        if (pcodepoint == nullptr) [[unlikely]] {
             // not found - draw [?] mark
             auto questionMark = GetCodepoint(m_typeface.defaultCharacter);
-            fn(ch, questionMark.first, questionMark.second, 0);
+            resolved[i] = {&questionMark.first, &questionMark.second, true};
         } else [[likely]] {
-            const int32_t kern = GetKern(prevGlyphIndex, codepointIter->second.glyphindex);
-            prevGlyphIndex = codepointIter->second.glyphindex;
-            fn(ch, page, codepointIter->second, kern * scaler);
+            // outlines are built together below, spread over the font loader's workers
+            if (pcodepoint->needsRasterization && !m_usesGlyphAtlas) [[unlikely]]
+                shapes.emplace_back(ppage, pcodepoint);
+            else
+                EnsureRasterized(*ppage, *pcodepoint);
+            resolved[i] = {ppage, pcodepoint, false};
         }
     }
+
+    if (!shapes.empty()) [[unlikely]]
+        RasterizeGlyphs(shapes);
+
+    for (const ResolvedCodepoint& entry : resolved) {
+        if (entry.ppage->isBufferDirty) [[unlikely]]
+            CommitPage(*entry.ppage);
+    }
+
+    for (size_t i = 0; i < decoded.size(); i++) {
+        const char32_t ch = decoded[i];
+        if (ch == '\n') [[unlikely]]
+             prevGlyphIndex = 0;
+
+        const ResolvedCodepoint& entry = resolved[i];
+        if (entry.isMissing) [[unlikely]] {
+            fn(ch, *entry.ppage, *entry.pcodepoint, 0);
+        } else [[likely]] {
+            const int32_t kern = GetKern(prevGlyphIndex, entry.pcodepoint->glyphindex);
+            prevGlyphIndex = entry.pcodepoint->glyphindex;
+            fn(ch, *entry.ppage, *entry.pcodepoint, kern * scaler);
+        }
+    }
+
+    s_pendingShapes = std::move(shapes);
+    s_resolvedText = std::move(resolved);
+    s_decodedText = std::move(decoded);
 }
 
 const CodepointPage& Font::GetCodepointPage(uint32_t ch) const
 {
-    return m_pages[uint32_t(ch / m_pageSize)];
+    static const CodepointPage s_emptyPage;
+    const CodepointPage* ppage = FindPage(uint32_t(ch / m_pageSize));
+    return ppage != nullptr ? *ppage : s_emptyPage;
 }
 
-int32_t Font::GetKern(char32_t ch1, char32_t ch2) const
+CodepointPage* Font::LoadPageOnDemand(uint32_t pageIndex) const
 {
-    if (m_spFontInfo == nullptr)
-        return 0;
+    // the default font comes with all of its codepoints
+    if (m_isDefaultFont)
+        return nullptr;
+
+    if (m_loadPagesInBackground)
+    {
+        // until the page arrives, Measure and ForEachCodepoint use the default character (i.e. '?') in its place
+        LoadPageInBackground(pageIndex, {});
+        return nullptr;
+    }
 
-    return stbtt__GetGlyphKernInfoAdvance(&m_spFontInfo->info, ch1, ch2);
+    InstallPage({pageIndex, LoadPage(pageIndex), {}});
+    return m_pages[pageIndex].get();
 }
 
-SizeF Font::Measure(std::string_view text) const
+void Font::LoadPageInBackground(uint32_t pageIndex, const std::vector<CodepointRange>& ranges) const
 {
-    float total_width = 0;
-    const size_t length = text.length();
+    if (!m_loadingPages.insert(pageIndex).second)
+        return;
 
-    if (m_typeface.fixedFont) {
-        size_t i = 0;
-        while (i < length) {
-            const uint32_t ch = stringex::utf8_to_utf32(text, i);
-            if (ch == 0) [[unlikely]]
-                break;
-            total_width += m_metrics.charWidth;
+    // installed fonts are never released, so the worker can hold on to this
+    FontLoader::Enqueue([this, pageIndex, ranges]()
+    {
+        auto spLoaded = std::make_shared<LoadedPage>(BuildPage(pageIndex, ranges));
+        FontLoader::Dispatch([this, spLoaded]()
+        {
+            InstallPage(std::move(*spLoaded));
+            s_epoch++;
+        });
+    });
+}
+
+Font::LoadedPage Font::BuildPage(uint32_t pageIndex, const std::vector<CodepointRange>& ranges) const
+{
+    LoadedPage loaded{pageIndex, LoadPage(pageIndex), {}};
+
+    const uint32_t pageStart = pageIndex * m_pageSize;
+    const uint32_t pageLast = pageStart + m_pageSize - 1;
+    std::vector<std::pair<CodepointPage*, Codepoint*>> shapes;
+    for (const CodepointRange& range : ranges)
+    {
+        const uint32_t first = std::max<uint32_t>(range.first, pageStart);
+        const uint32_t last = std::min<uint32_t>(range.last, pageLast);
+        for (uint32_t ch = first; ch <= last && first <= last; ch++)
+        {
+            Codepoint* pcodepoint = loaded.page.Find(ch - pageStart);
+            if (pcodepoint == nullptr || !pcodepoint->needsRasterization)
+                continue;
+
+            try {
+                // the atlas belongs to the UI thread, only the bitmap is rendered here
+                if (m_usesGlyphAtlas)
+                {
+                    GlyphBitmap& bitmap = loaded.bitmaps.emplace_back(RenderGlyphBitmap(*pcodepoint));
+                    bitmap.index = ch - pageStart;
+                    pcodepoint->needsRasterization = false;
+                }
+                else
+                {
+                    shapes.emplace_back(&loaded.page, pcodepoint);
+                }
+            } catch (const std::exception&) {
+                // glyph stays unrendered, drawing it reports the problem on the UI thread
+            }
         }
+    }
 
-        return SizeF{total_width, m_metrics.lineHeight};
+    try {
+        RasterizeGlyphs(shapes);
+    } catch (const std::exception&) {
+        // the glyphs that failed stay empty, the others are in the page
     }
 
-    uint32_t currentPageIndex = m_isDefaultFont ? 0 : std::numeric_limits<uint32_t>::max();
-    auto pageIter = m_isDefaultFont ? m_pages.cbegin() : m_pages.cend();
+    return loaded;
+}
 
-    size_t i = 0;
-    while (i < length) {
-        const uint32_t ch = stringex::utf8_to_utf32(text, i);
-        if (ch == 0) [[unlikely]]
-            break;
+void Font::InstallPage(LoadedPage&& loaded) const
+{
+    const uint32_t pageIndex = loaded.pageIndex;
+    m_loadingPages.erase(pageIndex);
 
-        const uint32_t pageIndex = uint32_t(ch / m_pageSize);
-        if (pageIndex != currentPageIndex) [[unlikely]] {
-            if (m_isDefaultFont) [[unlikely]] {
-                auto questionMark = GetCodepoint(m_typeface.defaultCharacter);
-                total_width += questionMark.second.advance;
-                continue;
-            }
+    if (pageIndex >= m_pages.size())
+        m_pages.resize(pageIndex + 1);
+    else if (m_pages[pageIndex] != nullptr)
+        return;
+
+    for (const GlyphBitmap& bitmap : loaded.bitmaps)
+        PlaceGlyphBitmap(loaded.page.codepoints[bitmap.index], bitmap);
+
+    m_pages[pageIndex] = std::make_unique<CodepointPage>(std::move(loaded.page));
+    if (pageIndex == 0)
+        m_pAsciiPage = m_pages[0].get();
+}
+
+SizeF Font::Measure(std::string_view text) const
+{
+    float total_width = 0;
+
+    if (m_typeface.fixedFont) {
+        total_width = stringex::get_char_count(text) * m_metrics.charWidth;
+        return SizeF{total_width, m_metrics.lineHeight};
+    }
 
-            pageIter = m_pages.find(pageIndex);
-            if (pageIter == m_pages.cend()) [[unlikely]] {
-                m_pages[pageIndex] = LoadPage(pageIndex);
-                pageIter = m_pages.find(pageIndex);
+    uint32_t currentPageIndex = std::numeric_limits<uint32_t>::max();
+    const CodepointPage* pcurrentPage = nullptr;
+
+    std::vector<char32_t> decoded = std::move(s_decodedText);
+    stringex::utf8_to_utf32(text, decoded);
+
+    for (const char32_t ch : decoded) {
+        const Codepoint* pcodepoint = nullptr;
+        if (ch < c_asciiRange && m_pAsciiPage != nullptr) [[likely]] {
+            pcodepoint = m_pAsciiPage->Find(ch);
+        } else {
+            const uint32_t pageIndex = uint32_t(ch / m_pageSize);
+            if (pageIndex != currentPageIndex) [[unlikely]] {
+                pcurrentPage = FindPage(pageIndex);
+                currentPageIndex = pageIndex;
             }
 
-            currentPageIndex = pageIndex;
+            if (pcurrentPage != nullptr)
+                pcodepoint = pcurrentPage->Find(ch % m_pageSize);
         }
 
-        const CodepointPage& page = pageIter->second;
-        const uint32_t codepointIndex = ch % m_pageSize;
-
-        const auto codepointIter = page.codepoints.find(codepointIndex);
-        if (codepointIter == page.codepoints.cend()) [[unlikely]] {
+        if (pcodepoint == nullptr) [[unlikely]] {
             // not found - draw [?] mark
             auto questionMark = GetCodepoint(m_typeface.defaultCharacter);
             total_width += questionMark.second.advance;
         } else [[likely]] {
-            total_width += codepointIter->second.advance;
+            total_width += pcodepoint->advance;
         }
     }
 
+    s_decodedText = std::move(decoded);
     return SizeF{total_width, m_metrics.lineHeight};
 }
 
@@ -338,24 +453,17 @@ const std::pair<CodepointPage&, const Codepoint&> Font::GetCodepoint(char32_t ch
     static Codepoint s_emptyCodepointInfo;
     static CodepointPage s_emptyPage;
 
-    const uint32_t pageIndex = uint32_t(ch / m_pageSize);
-    auto pageIter = m_pages.find(pageIndex);
-    if (pageIter == m_pages.cend()) {
-        if (m_isDefaultFont)
-            return {s_emptyPage, s_emptyCodepointInfo};
-
-        m_pages[pageIndex] = LoadPage(pageIndex);
-        pageIter = m_pages.find(pageIndex);
-    }
-
-    const CodepointPage& page = pageIter->second;
-    const uint32_t codepointIndex = ch % m_pageSize;
+    CodepointPage* ppage = FindPage(uint32_t(ch / m_pageSize));
+    if (ppage == nullptr)
+        return {s_emptyPage, s_emptyCodepointInfo};
 
-    const auto codepointIter = page.codepoints.find(codepointIndex);
-    if (codepointIter == page.codepoints.cend())
+    Codepoint* pcodepoint = ppage->Find(ch % m_pageSize);
+    if (pcodepoint == nullptr)
         return {s_emptyPage, s_emptyCodepointInfo};
 
-    return {pageIter->second, codepointIter->second};
+    EnsureRasterized(*ppage, *pcodepoint);
+    CommitPage(*ppage);
+    return {*ppage, *pcodepoint};
 }
 
 void earcut(std::vector<std::vector<Point16>>& polygon, int16_t ascent16, triangle_range3& tris)
@@ -387,327 +495,455 @@ void earcut(std::vector<std::vector<Point16>>& polygon, int16_t ascent16, triang
     }
 }
 
-CodepointPage Font::LoadPageForShadedTris(uint32_t pageIndex) const
+CodepointPage Font::LoadPage(uint32_t pageIndex) const
 {
+    // only metrics are read here, outlines and bitmaps are built per glyph on first use (EnsureRasterized)
+    const bool isShaderRendered = m_supportsLineShading && m_typeface.renderOptions & FontRenderOptions::Shaded;
+    const bool isShaderRenderedByTris = m_supportsTriShading && m_typeface.renderOptions & FontRenderOptions::ShadedByTris;
+
     uint32_t pageStart = pageIndex * c_pageSize;
     uint32_t pageEnd = pageStart + c_pageSize;
-    int16_t ascent16 = m_metrics.ascent;
     const stbtt_fontinfo* pfont_info = &(m_spFontInfo->info);
 
-    std::vector<int16_t> tris;
-    tris.push_back(1);
-
     CodepointPage codepointPage;
+    codepointPage.Resize(c_pageSize);
+    if (isShaderRenderedByTris)
+        codepointPage.outlines.push_back(1);
+    else if (isShaderRendered)
+        codepointPage.outlines.push_back(0);
+
+    if (m_spGlyphCache != nullptr && m_spGlyphCache->RestorePage(pageIndex, codepointPage))
+        return codepointPage;
+
     for (uint32_t ch32 = pageStart; ch32 < pageEnd; ch32++)
     {
-        if (ch32 == 0xe7) // 'ç')
-            ch32 += 0;
         const int32_t glyphIndex = stbtt_FindGlyphIndex(pfont_info, int32_t(ch32));
+
         int32_t advanceX = 0;
         int32_t bearingX = 0;
         stbtt_GetGlyphHMetrics(pfont_info, glyphIndex, &advanceX, &bearingX);
 
-        int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
-        stbtt_GetGlyphBitmapBoxSubpixel(pfont_info, glyphIndex, 1.0, 1.0, 0.0, 0.0, &x0,&y0,&x1,&y1);
-        int32_t width = x1 - x0;
-        int32_t height = y1 - y0;
-        int32_t xoffset = x0;
-        int32_t yoffset = y0;
+        Codepoint codepoint;
+        codepoint.glyphindex = glyphIndex;
+        codepoint.needsRasterization = true;
+        if (isShaderRendered || isShaderRenderedByTris)
+        {
+            // NOTE: ascent is equivalent to font baseline
+            int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+            stbtt_GetGlyphBitmapBoxSubpixel(pfont_info, glyphIndex, 1.0, 1.0, 0.0, 0.0, &x0,&y0,&x1,&y1);
+            codepoint.width = x1 - x0;
+            codepoint.height = y1 - y0;
+            codepoint.xoffset = x0;
+            codepoint.yoffset = y0;
+            codepoint.bearingX = bearingX;
+            codepoint.advance = advanceX;
+            codepoint.texCoords = {0,0,1,1};
+        }
+        else
+        {
+            codepoint.bearingX = bearingX * m_scale;
+            codepoint.advance = advanceX * m_scale;
+        }
+
+        codepointPage.Set(ch32 - pageStart, std::move(codepoint));
+    }
+
+    return codepointPage;
+}
+
+void Font::BuildGlyphTriangles(const Codepoint& codepoint, std::vector<int16_t>& tris) const
+{
+    int16_t ascent16 = m_metrics.ascent;
+    const stbtt_fontinfo* pfont_info = &(m_spFontInfo->info);
+    const int32_t glyphIndex = codepoint.glyphindex;
+    const int32_t yoffset = int32_t(codepoint.yoffset);
 
-        stbtt_vertex* pvertices = nullptr;
-        int32_t num_vertices = stbtt_GetGlyphShape(pfont_info, glyphIndex, &pvertices);
+    stbtt_vertex* pvertices = nullptr;
+    int32_t num_vertices = stbtt_GetGlyphShape(pfont_info, glyphIndex, &pvertices);
 
-        Codepoint& codepoint = codepointPage.codepoints[ch32 - pageStart];
-        codepoint.glyphindex = glyphIndex;
-        codepoint.xoffset = xoffset;
-        codepoint.yoffset = yoffset;
-        codepoint.width = width;
-        codepoint.height = height;
-        codepoint.bearingX = bearingX;
-        codepoint.advance = advanceX;
-        codepoint.texCoords = {0,0,1,1};
-        codepoint.glyphStartOffset = static_cast<uint32_t>(tris.size());
-        size_t countOfContoursIndex = tris.size();
-        tris.push_back(0); // countOfContoursIndex;
+    size_t countOfContoursIndex = tris.size();
+    tris.push_back(0); // countOfContoursIndex;
 
+    int16_t x = 0, y = 0;
+    std::vector<std::vector<Point16>> polygon;
+    std::vector<Point16>& contour = polygon.emplace_back();
+    std::vector<triangle_range3> triangles;
+    triangle_range3 current;
+    triangle_range3 bz;
+    triangle_range3 bz_ccw;
+
+    for (int32_t vindex = 0; vindex < num_vertices; vindex++)
+    {
+        stbtt_vertex& vrtx = pvertices[vindex];
+        vrtx.y += m_metrics.baseline + yoffset;
+        vrtx.cy += m_metrics.baseline + yoffset;
+        vrtx.cy1 += m_metrics.baseline + yoffset;
+        if (vrtx.type == STBTT_vmove)
+        {
+            if (contour.size() != 0)
+            {
+                if (contour.size() < 3)
+                    throw std::exception(); // invalid contour
+
+                earcut(polygon, ascent16, current);
+                contour.clear();
+                triangles.push_back(std::move(current));
+                current = triangle_range3();
+            }
+        }
+        else if (vrtx.type == STBTT_vline)
+        {
+            Point16 a{x, y};
+            contour.push_back(a);
+        }
+        else if (vrtx.type == STBTT_vcurve)
+        {
+            contour.push_back({x, y});
+            Point16 a{x, (int16_t)(ascent16 - y)};
+            Point16 b{vrtx.cx, (int16_t)(ascent16 - vrtx.cy)};
+            Point16 c{vrtx.x, (int16_t)(ascent16 - vrtx.y)};
+            bool ccw = Point16::normal(a, b, c) < 0;
+            if (ccw)
+            {
+                contour.push_back(Point16{vrtx.cx, vrtx.cy});
+                bz_ccw.push(a, b, c);
+            }
+            else
+            {
+                bz.push(a, b, c);
+            }
+        }
+        else if (vrtx.type == STBTT_vcubic)
+        {
+            throw std::exception(); // NYI
+        }
+
+        x = vrtx.x; y = vrtx.y;
+    }
+
+    if (!contour.empty())
+    {
+        earcut(polygon, ascent16, current);
+        contour.clear();
+        triangles.push_back(std::move(current));
+    }
+
+    for (auto& bzi : triangles)
+        bzi.finalize(0, tris, countOfContoursIndex);
+    bz_ccw.finalize(1, tris, countOfContoursIndex);
+    bz.finalize(-1,tris, countOfContoursIndex);
+
+    STBTT_free(pvertices, pfont_info->userdata);
+}
+
+void Font::BuildGlyphOutline(const Codepoint& codepoint, std::vector<int16_t>& points) const
+{
+    int16_t ascent16 = m_metrics.ascent;
+    const stbtt_fontinfo* pfont_info = &(m_spFontInfo->info);
+    const int32_t glyphIndex = codepoint.glyphindex;
+    const int32_t yoffset = int32_t(codepoint.yoffset);
+    std::vector<int16_t> bezierCurvePoints;
+
+    stbtt_vertex* pvertices = nullptr;
+    int count = stbtt_GetGlyphShape(pfont_info, glyphIndex, &pvertices);
+    if (count > 0)
+    {
         int16_t x = 0, y = 0;
-        std::vector<std::vector<Point16>> polygon;
-        std::vector<Point16>& contour = polygon.emplace_back();
-        std::vector<triangle_range3> triangles;
-        triangle_range3 current;
-        triangle_range3 bz;
-        triangle_range3 bz_ccw;
-
-        for (int32_t vindex = 0; vindex < num_vertices; vindex++)
+
+        size_t glyphStart = points.size();
+        points.push_back(0); // reserve space for length of glyph data.
+        size_t contourStart = points.size(); // start of contour: len + (x,y: (short * 2)*len)
+        for (int i = 0; i < count; i++)
         {
-            stbtt_vertex& vrtx = pvertices[vindex];
+            stbtt_vertex& vrtx = pvertices[i];
             vrtx.y += m_metrics.baseline + yoffset;
             vrtx.cy += m_metrics.baseline + yoffset;
             vrtx.cy1 += m_metrics.baseline + yoffset;
+
             if (vrtx.type == STBTT_vmove)
             {
-                if (contour.size() != 0)
-                {
-                    if (contour.size() < 3)
-                        throw std::exception(); // invalid contour
+                if (points.size() - contourStart > 0)
+                    points[contourStart] = (points.size() - (contourStart + 1)) / 2;
 
-                    earcut(polygon, ascent16, current);
-                    contour.clear();
-                    triangles.push_back(std::move(current));
-                    current = triangle_range3();
-                }
+                contourStart = (int)points.size();
+
+                points.push_back(0); // space for contour count - sign shows winding direction
+                points.push_back(vrtx.x); points.push_back(ascent16 - vrtx.y);
             }
             else if (vrtx.type == STBTT_vline)
             {
-                Point16 a{x, y};
-                contour.push_back(a);
+                points.push_back(vrtx.x); points.push_back(ascent16 - vrtx.y);
             }
             else if (vrtx.type == STBTT_vcurve)
             {
-                contour.push_back({x, y});
-                Point16 a{x, (int16_t)(ascent16 - y)};
-                Point16 b{vrtx.cx, (int16_t)(ascent16 - vrtx.cy)};
-                Point16 c{vrtx.x, (int16_t)(ascent16 - vrtx.y)};
-                bool ccw = Point16::normal(a, b, c) < 0;
-                if (ccw)
-                {
-                    contour.push_back(Point16{vrtx.cx, vrtx.cy});
-                    bz_ccw.push(a, b, c);
-                }
-                else
-                {
-                    bz.push(a, b, c);
-                }
+    #if TESSELATE
+                stbtt_tesselate_curve(
+                    points,
+                    x, (ascent - y),
+                    vrtx.cx, (ascent - vrtx.cy),
+                    vrtx.x, (ascent - vrtx.y));
+    #else
+                bezierCurvePoints.push_back(x);
+                bezierCurvePoints.push_back((ascent16 - y));
+
+                bezierCurvePoints.push_back(vrtx.cx);
+                bezierCurvePoints.push_back((ascent16 - vrtx.cy));
+
+                bezierCurvePoints.push_back(vrtx.x);
+                bezierCurvePoints.push_back((ascent16 - vrtx.y));
+                points.push_back(vrtx.x); points.push_back(ascent16 - vrtx.y);
+    #endif
             }
             else if (vrtx.type == STBTT_vcubic)
             {
-                throw std::exception(); // NYI
+                stbtt_tesselate_cubic(
+                    points,
+                    x, (ascent16 - y),
+                    vrtx.cx, (ascent16 - vrtx.cy),
+                    vrtx.cx1, (ascent16 - vrtx.cy1),
+                    vrtx.x, (ascent16 - vrtx.y));
+            }
+            else
+            {
+                throw std::exception();
             }
 
             x = vrtx.x; y = vrtx.y;
         }
 
-        if (!contour.empty())
-        {
-            earcut(polygon, ascent16, current);
-            contour.clear();
-            triangles.push_back(std::move(current));
-        }
+        points[contourStart] = (points.size() - (contourStart + 1)) / 2;
+        points[glyphStart] = (points.size() - glyphStart);
 
-        for (auto& bzi : triangles)
-            bzi.finalize(0, tris, countOfContoursIndex);
-        bz_ccw.finalize(1, tris, countOfContoursIndex);
-        bz.finalize(-1,tris, countOfContoursIndex);
+        points.push_back(bezierCurvePoints.size() / 6);
+        for (const int16_t v : bezierCurvePoints)
+            points.push_back(v);
+        bezierCurvePoints.clear();
 
         STBTT_free(pvertices, pfont_info->userdata);
     }
+}
 
-    codepointPage.spBuffer = IBuffer::BufferLoader(reinterpret_cast<const byte_t*>(tris.data()), tris.size() * sizeof(tris[0]));
+// only reads the font and its cache, safe on any thread
+void Font::BuildGlyphShape(const Codepoint& codepoint, std::vector<int16_t>& shape) const
+{
+    // outline or triangles an earlier run built for the glyph, see GlyphCache
+    if (m_spGlyphCache != nullptr)
+    {
+        const GlyphCache::Glyph* pcached = m_spGlyphCache->FindGlyph(codepoint.glyphindex);
+        if (pcached != nullptr)
+            return m_spGlyphCache->AppendOutline(*pcached, shape);
+    }
 
-    return codepointPage;
+    if (m_supportsTriShading && m_typeface.renderOptions & FontRenderOptions::ShadedByTris)
+        BuildGlyphTriangles(codepoint, shape);
+    else
+        BuildGlyphOutline(codepoint, shape);
 }
 
-CodepointPage Font::LoadPage(uint32_t pageIndex) const
+void Font::RasterizeGlyph(CodepointPage& page, Codepoint& codepoint) const
 {
-    const bool isShaderRendered = m_supportsLineShading && m_typeface.renderOptions & FontRenderOptions::Shaded;
-    const bool isShaderRenderedByTris = m_supportsTriShading && m_typeface.renderOptions & FontRenderOptions::ShadedByTris;
+    codepoint.needsRasterization = false;
+    if (m_usesGlyphAtlas)
+        return RasterizeGlyph(codepoint);
 
-    if (isShaderRenderedByTris)
-        return LoadPageForShadedTris(pageIndex);
+    codepoint.glyphStartOffset = static_cast<uint32_t>(page.outlines.size());
+    page.isBufferDirty = true;
+    BuildGlyphShape(codepoint, page.outlines);
+}
 
-    uint32_t pageStart = pageIndex * c_pageSize;
-    uint32_t pageEnd = pageStart + c_pageSize;
-    int32_t atlasWidth = 0, atlasHeight = 0;
+void Font::RasterizeGlyphs(std::vector<std::pair<CodepointPage*, Codepoint*>>& glyphs) const
+{
+    if (glyphs.size() < c_minParallelGlyphs)
+    {
+        for (const auto& [ppage, pcodepoint] : glyphs)
+        {
+            if (pcodepoint->needsRasterization)
+                RasterizeGlyph(*ppage, *pcodepoint);
+        }
+        return;
+    }
 
-    int16_t ascent16 = m_metrics.ascent;
-    const stbtt_fontinfo* pfont_info = &(m_spFontInfo->info);
-    std::vector<byte_t> atlas;
-    uint32_t atlasX = 0;
-    float atlasWidthScale = 0;
-    float atlasHeightScale = 0;
+    // pages keep their codepoints in order, sorting by address appends them in codepoint order
+    std::sort(glyphs.begin(), glyphs.end());
+    glyphs.erase(std::unique(glyphs.begin(), glyphs.end()), glyphs.end());
 
-    if (!isShaderRendered) // cpu rendered fonts
+    std::vector<std::vector<int16_t>> shapes(glyphs.size());
+    std::vector<std::exception_ptr> errors(glyphs.size());
+    FontLoader::ParallelFor(glyphs.size(), [&](size_t i)
     {
-        for (char32_t ch32 = pageStart; ch32 < pageEnd; ch32++)
+        try {
+            BuildGlyphShape(*glyphs[i].second, shapes[i]);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    });
+
+    std::exception_ptr error;
+    for (size_t i = 0; i < glyphs.size(); i++)
+    {
+        auto [ppage, pcodepoint] = glyphs[i];
+        pcodepoint->needsRasterization = false;
+        if (errors[i] != nullptr) [[unlikely]]
         {
-            int32_t ix0 = 0, iy0 = 0, ix1 = 0, iy1 = 0;
-            stbtt_GetCodepointBitmapBox(pfont_info, int32_t(ch32), m_scale, m_scale, &ix0, &iy0, &ix1, &iy1);
-            atlasWidth += (ix1 -ix0);
-            int32_t height = (iy1 -iy0);
-            if (height > atlasHeight)
-                atlasHeight = height;
+            if (error == nullptr)
+                error = errors[i];
+            continue;
         }
 
-        atlasWidthScale = 1.0f / float(atlasWidth);
-        atlasHeightScale = 1.0f / float(atlasHeight);
-        atlas = std::vector<byte_t>(atlasWidth * atlasHeight * sizeof(uint8_t));
+        pcodepoint->glyphStartOffset = static_cast<uint32_t>(ppage->outlines.size());
+        ppage->outlines.insert(ppage->outlines.end(), shapes[i].begin(), shapes[i].end());
+        ppage->isBufferDirty = true;
     }
 
-    std::vector<int16_t> points;
-    std::vector<int16_t> bezierCurvePoints;
-    points.push_back(0);
+    if (error != nullptr) [[unlikely]]
+        std::rethrow_exception(error);
+}
 
-    CodepointPage codepointPage;
-    for (uint32_t ch32 = pageStart; ch32 < pageEnd; ch32++)
-    {
-        const int32_t glyphIndex = stbtt_FindGlyphIndex(pfont_info, int32_t(ch32));
+void Font::CommitPage(CodepointPage& page) const
+{
+    if (!page.isBufferDirty)
+        return;
 
-        int32_t advanceX = 0;
-        int32_t bearingX = 0;
-        stbtt_GetGlyphHMetrics(pfont_info, glyphIndex, &advanceX, &bearingX);
+    page.isBufferDirty = false;
+    page.spBuffer = IBuffer::BufferLoader(reinterpret_cast<const byte_t*>(page.outlines.data()), page.outlines.size() * sizeof(page.outlines[0]));
+}
 
-        Codepoint codepoint;
-        // Calculate font basic metrics
-        // NOTE: ascent is equivalent to font baseline
-        int32_t width = 0, height = 0, xoffset = 0, yoffset = 0;
-        if (isShaderRendered) // shader rendered fonts
+Font::GlyphBitmap Font::RenderGlyphBitmap(const Codepoint& codepoint) const
+{
+    if (m_spGlyphCache != nullptr)
+    {
+        const GlyphCache::Glyph* pcached = m_spGlyphCache->FindGlyph(codepoint.glyphindex);
+        if (pcached != nullptr && pcached->pixelCount == uint32_t(pcached->width * pcached->height))
         {
-            codepoint.glyphStartOffset = static_cast<uint32_t>(points.size());
-
-            int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
-            stbtt_GetGlyphBitmapBoxSubpixel(pfont_info, glyphIndex, 1.0, 1.0, 0.0, 0.0, &x0,&y0,&x1,&y1);
-            width = x1 - x0;
-            height = y1 - y0;
-            xoffset = x0;
-            yoffset = y0;
-
-            stbtt_vertex* pvertices = nullptr;
-            int count = stbtt_GetGlyphShape(pfont_info, glyphIndex, &pvertices);
-            if (count > 0)
-            {
-                int16_t x = 0, y = 0;
+            GlyphBitmap bitmap;
+            bitmap.width = pcached->width;
+            bitmap.height = pcached->height;
+            bitmap.xoffset = pcached->xoffset;
+            bitmap.yoffset = pcached->yoffset;
+            const byte_t* ppixels = m_spGlyphCache->GetPixels(*pcached);
+            bitmap.pixels.assign(ppixels, ppixels + pcached->pixelCount);
+            return bitmap;
+        }
+    }
 
-                size_t glyphStart = points.size();
-                points.push_back(0); // reserve space for length of glyph data.
-                size_t contourStart = points.size(); // start of contour: len + (x,y: (short * 2)*len)
-                for (int i = 0; i < count; i++)
-                {
-                    stbtt_vertex& vrtx = pvertices[i];
-                    vrtx.y += m_metrics.baseline + yoffset;
-                    vrtx.cy += m_metrics.baseline + yoffset;
-                    vrtx.cy1 += m_metrics.baseline + yoffset;
+    int32_t width = 0, height = 0, xoffset = 0, yoffset = 0;
+    byte_t* pbitmap = nullptr;
+    if (m_isDistanceField)
+    {
+        // edge at 128, one pixel away from it changes the value by 128 / padding
+        constexpr uint8_t onEdgeValue = 128;
+        constexpr float pixelDistanceScale = float(onEdgeValue) / float(c_distanceFieldPadding);
+        pbitmap = stbtt_GetGlyphSDF(
+            &m_spFontInfo->info, m_scale, codepoint.glyphindex,
+            c_distanceFieldPadding, onEdgeValue, pixelDistanceScale,
+            &width, &height, &xoffset, &yoffset);
+    }
+    else
+    {
+        pbitmap = stbtt_GetGlyphBitmap(&m_spFontInfo->info, m_scale, m_scale, codepoint.glyphindex, &width, &height, &xoffset, &yoffset);
+    }
 
-                    if (vrtx.type == STBTT_vmove)
-                    {
-                        if (points.size() - contourStart > 0)
-                            points[contourStart] = (points.size() - (contourStart + 1)) / 2;
+    GlyphBitmap bitmap;
+    bitmap.width = width;
+    bitmap.height = height;
+    bitmap.xoffset = xoffset;
+    bitmap.yoffset = yoffset;
+    if (pbitmap != nullptr)
+        bitmap.pixels.assign(pbitmap, pbitmap + width * height);
 
-                        contourStart = (int)points.size();
+    if (m_isDistanceField)
+        stbtt_FreeSDF(pbitmap, /*userdata:*/ nullptr);
+    else
+        stbtt_FreeBitmap(pbitmap, /*userdata:*/ nullptr);
 
-                        points.push_back(0); // space for contour count - sign shows winding direction
-                        points.push_back(vrtx.x); points.push_back(ascent16 - vrtx.y);
-                    }
-                    else if (vrtx.type == STBTT_vline)
-                    {
-                        points.push_back(vrtx.x); points.push_back(ascent16 - vrtx.y);
-                    }
-                    else if (vrtx.type == STBTT_vcurve)
-                    {
-    #if TESSELATE
-                        stbtt_tesselate_curve(
-                            points,
-                            x, (ascent - y),
-                            vrtx.cx, (ascent - vrtx.cy),
-                            vrtx.x, (ascent - vrtx.y));
-    #else
-                        bezierCurvePoints.push_back(x);
-                        bezierCurvePoints.push_back((ascent16 - y));
+    return bitmap;
+}
 
-                        bezierCurvePoints.push_back(vrtx.cx);
-                        bezierCurvePoints.push_back((ascent16 - vrtx.cy));
+void Font::PlaceGlyphBitmap(Codepoint& codepoint, const GlyphBitmap& bitmap) const
+{
+    codepoint.xoffset = bitmap.xoffset;
+    codepoint.yoffset = bitmap.yoffset;
+    codepoint.width = bitmap.width;
+    codepoint.height = bitmap.height;
+
+    const ITexture::Interpolation interpolation = m_isDistanceField
+        ? ITexture::Interpolation::Linear
+        : ITexture::Interpolation::None;
+    if (GlyphAtlas::Allocate(uint16_t(bitmap.width), uint16_t(bitmap.height), codepoint.atlasSlot, interpolation))
+        GlyphAtlas::Write(codepoint.atlasSlot, bitmap.pixels.data(), uint32_t(bitmap.width));
+}
 
-                        bezierCurvePoints.push_back(vrtx.x);
-                        bezierCurvePoints.push_back((ascent16 - vrtx.y));
-                        points.push_back(vrtx.x); points.push_back(ascent16 - vrtx.y);
-    #endif
-                    }
-                    else if (vrtx.type == STBTT_vcubic)
-                    {
-                        stbtt_tesselate_cubic(
-                            points,
-                            x, (ascent16 - y),
-                            vrtx.cx, (ascent16 - vrtx.cy),
-                            vrtx.cx1, (ascent16 - vrtx.cy1),
-                            vrtx.x, (ascent16 - vrtx.y));
-                    }
-                    else
-                    {
-                        throw std::exception();
-                    }
+void Font::SaveGlyphCache() const
+{
+    if (m_spGlyphCache == nullptr)
+        return;
 
-                    x = vrtx.x; y = vrtx.y;
-                }
+    GlyphCache::Writer writer;
+    std::vector<byte_t> pixels;
+    std::vector<std::pair<uint32_t, const Codepoint*>> outlines; // by start offset
+    for (uint32_t pageIndex = 0; pageIndex < m_pages.size(); pageIndex++)
+    {
+        const CodepointPage* ppage = m_pages[pageIndex].get();
+        if (ppage == nullptr)
+            continue;
 
-                points[contourStart] = (points.size() - (contourStart + 1)) / 2;
-                points[glyphStart] = (points.size() - codepoint.glyphStartOffset);
+        writer.AddPage(pageIndex, *ppage);
 
-                points.push_back(bezierCurvePoints.size() / 6);
-                for (const int16_t v : bezierCurvePoints)
-                    points.push_back(v);
-                bezierCurvePoints.clear();
+        outlines.clear();
+        for (uint32_t index = 0; index < ppage->codepoints.size(); index++)
+        {
+            const Codepoint* pcodepoint = ppage->Find(index);
+            if (pcodepoint == nullptr || pcodepoint->needsRasterization)
+                continue;
 
-                STBTT_free(pvertices, pfont_info->userdata);
+            if (!m_usesGlyphAtlas)
+            {
+                outlines.emplace_back(pcodepoint->glyphStartOffset, pcodepoint);
+                continue;
             }
+
+            GlyphCache::Glyph glyph;
+            glyph.width = int32_t(pcodepoint->width);
+            glyph.height = int32_t(pcodepoint->height);
+            glyph.xoffset = int32_t(pcodepoint->xoffset);
+            glyph.yoffset = int32_t(pcodepoint->yoffset);
+            pixels.clear();
+            if (pcodepoint->atlasSlot.IsAllocated() && !GlyphAtlas::Read(pcodepoint->atlasSlot, pixels))
+                continue; // evicted, rendered again next run
+            glyph.pixelCount = uint32_t(pixels.size());
+            writer.AddGlyph(pcodepoint->glyphindex, glyph, nullptr, pixels.data());
         }
-        else
+
+        // glyphs were appended one after another, each one ends where the next one starts
+        std::sort(outlines.begin(), outlines.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (size_t i = 0; i < outlines.size(); i++)
         {
-            // if (m_use_sdf_to_generate_fonts) {
-            //     pageData = stbtt_GetCodepointSDF(pfont_info, m_scale, ch32, /*padding:*/4, /*onedge_value:*/ 255, /*pixel_dist_scale:*/ 64.0f, &width, &height, &xoffset, &yoffset);
-            // } else {
-            // }
-
-            uint8_t* pImageData = (uint8_t*)atlas.data();
-            byte_t* pageData = stbtt_GetGlyphBitmap(pfont_info, m_scale, m_scale, glyphIndex, &width, &height, &xoffset, &yoffset);
-            byte_t* pdata = pageData;
-
-            for (int32_t h = 0; h < height; h++) {
-                for (int32_t p = 0; p < width; p++) {
-                    uint8_t val = *(pdata++);
-                    pImageData[atlasX + p + h * atlasWidth] = val;
+            const Codepoint& codepoint = *outlines[i].second;
+            uint32_t end = uint32_t(ppage->outlines.size());
+            for (size_t next = i + 1; next < outlines.size(); next++)
+            {
+                if (outlines[next].first > codepoint.glyphStartOffset)
+                {
+                    end = outlines[next].first;
+                    break;
                 }
             }
 
-            stbtt_FreeBitmap(pageData, /*userdata:*/ nullptr);
-        }
-
-        codepoint.glyphindex = glyphIndex;
-        codepoint.xoffset = xoffset;
-        codepoint.yoffset = yoffset;
-        codepoint.width = width;
-        codepoint.height = height;
-        if (isShaderRendered)
-        {
-            codepoint.bearingX = bearingX;
-            codepoint.advance = advanceX;
-            codepoint.texCoords = {0,0,1,1};
-        }
-        else
-        {
-            codepoint.bearingX = bearingX * m_scale;
-            codepoint.advance = advanceX * m_scale;
-            rectf_t rect;
-            rect.x = atlasX;
-            rect.y = 0;
-            rect.w = width;
-            rect.h = height;
-            codepoint.texCoords = rect.multiply(atlasWidthScale, atlasHeightScale);
+            // empty glyphs append nothing and share their offset with the glyph after them
+            GlyphCache::Glyph glyph;
+            if (!stbtt_IsGlyphEmpty(&m_spFontInfo->info, codepoint.glyphindex))
+                glyph.outlineCount = end - codepoint.glyphStartOffset;
+            writer.AddGlyph(codepoint.glyphindex, glyph, ppage->outlines.data() + codepoint.glyphStartOffset, nullptr);
         }
-
-        codepointPage.codepoints[ch32 - pageStart] = std::move(codepoint);
-
-        atlasX += width;
     }
 
-    if (m_typeface.renderOptions & FontRenderOptions::Shaded)
-    {
-        codepointPage.spBuffer = IBuffer::BufferLoader(reinterpret_cast<const byte_t*>(points.data()), points.size() * sizeof(points[0]));
-    }
-    else
-    {
-        codepointPage.spTexture = ITexture::TextureLoader(std::move(atlas), atlasWidth, atlasHeight, PixelFormat::GrayScale, /*mipMapCount*/ 1);
-    }
+    writer.Save(*m_spGlyphCache);
+}
 
-    return codepointPage;
+/*static*/ void Font::SaveGlyphCaches()
+{
+    for (const auto& [key, spFont] : s_installedFonts)
+        spFont->SaveGlyphCache();
 }
 
 /*static*/ const std::shared_ptr<xpf::Font>& Font::GetDefaultFont()
@@ -802,7 +1038,7 @@ CodepointPage Font::LoadPage(uint32_t pageIndex) const
     uint32_t currentPosX = charsDivisor;
     uint32_t testPosX = charsDivisor;
 
-    codepointPage.codepoints.reserve(pageSize);
+    codepointPage.Resize(pageSize);
     for (uint32_t i = 0; i < codepointCount; i++)
     {
         Codepoint codepoint;
@@ -834,7 +1070,7 @@ CodepointPage Font::LoadPage(uint32_t pageIndex) const
 
         codepoint.texCoords = rect.multiply(c_textureWidthScale, c_textureWidthScale);
 
-        codepointPage.codepoints[32 + i] = std::move(codepoint);
+        codepointPage.Set(32 + i, std::move(codepoint));
     }
 
     std::shared_ptr<xpf::Font> spFont = std::make_shared<xpf::Font>(HideConstructor());
@@ -851,13 +1087,14 @@ CodepointPage Font::LoadPage(uint32_t pageIndex) const
     spFont->m_metrics.lineHeight = charsHeight;
     spFont->m_metrics.advanceNewlineX = 0.0f;
     spFont->m_metrics.advanceNewlineY = 1.0f;
-    spFont->m_pages[0] = std::move(codepointPage);
+    spFont->m_pages.push_back(std::make_unique<CodepointPage>(std::move(codepointPage)));
+    spFont->m_pAsciiPage = spFont->m_pages[0].get();
     spFont->m_isDefaultFont = true;
 
     return spFont;
 }
 
-/*static*/ std::shared_ptr<Font> Font::LoadFont(const Typeface& typeface)
+/*static*/ std::shared_ptr<Font> Font::LoadFont(const Typeface& typeface, const FontData& fontData)
 {
     xpf::Font font;
     font.m_pageSize = c_pageSize;
@@ -865,17 +1102,25 @@ CodepointPage Font::LoadPage(uint32_t pageIndex) const
     if (font.m_typeface.size == 0)
         font.m_typeface.size = 10;
 
-    const FontData& fontData = s_loadedTrueTypeFile[typeface.name];
-    const std::vector<byte_t>& data = fontData.data;
+    // distance fields are rendered once at a reference size and scaled to whatever size is asked for
+    font.m_isDistanceField = typeface.renderOptions & FontRenderOptions::DistanceField &&
+        !(typeface.renderOptions & FontRenderOptions::Shaded || typeface.renderOptions & FontRenderOptions::ShadedByTris);
+    if (font.m_isDistanceField)
+        font.m_typeface.size = c_distanceFieldSize;
+
+    const byte_t* pdata = fontData.spFile->data();
     font.m_supportsLineShading = fontData.supportsLineShading;
     font.m_supportsTextureShading = fontData.supportsTextureShading;
     font.m_supportsTriShading = fontData.supportsTriShading;
+    font.m_usesGlyphAtlas =
+        !(font.m_supportsLineShading && typeface.renderOptions & FontRenderOptions::Shaded) &&
+        !(font.m_supportsTriShading && typeface.renderOptions & FontRenderOptions::ShadedByTris);
 
     stbtt_fontinfo fontInfo;
     if (!stbtt_InitFont(
         &fontInfo,
-        data.data(),
-        stbtt_GetFontOffsetForIndex(data.data(), font.m_typeface.index))) {
+        pdata,
+        stbtt_GetFontOffsetForIndex(pdata, font.m_typeface.index))) {
 
         Log::error(
             "Font: " + font.m_typeface.name +
@@ -884,8 +1129,8 @@ CodepointPage Font::LoadPage(uint32_t pageIndex) const
 
         if (!stbtt_InitFont(
             &fontInfo,
-            data.data(),
-            stbtt_GetFontOffsetForIndex(data.data(), 0))) {
+            pdata,
+            stbtt_GetFontOffsetForIndex(pdata, 0))) {
 
             Log::error("Font: " + font.m_typeface.name + " failed to initialize.");
             return nullptr;
@@ -925,6 +1170,14 @@ CodepointPage Font::LoadPage(uint32_t pageIndex) const
 
     font.m_spFontInfo = std::make_shared<FontInfo>();
     font.m_spFontInfo->info = std::move(fontInfo);
+    font.m_spFontInfo->spFile = fontData.spFile;
+    font.m_kerning.Build(font.m_spFontInfo->info);
+
+    if (fontData.contentHash != 0)
+    {
+        const char* mode = font.m_usesGlyphAtlas ? "a" : (typeface.renderOptions & FontRenderOptions::ShadedByTris ? "t" : "l");
+        font.m_spGlyphCache = GlyphCache::Open(GetInstalledFontKey(typeface) + mode, fontData.contentHash);
+    }
 
     if (font.m_typeface.fixedFont) {
         std::string_view s_textToMeasure = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
@@ -935,33 +1188,119 @@ CodepointPage Font::LoadPage(uint32_t pageIndex) const
     return std::make_shared<xpf::Font>(std::move(font));
 }
 
-static std::vector<byte_t> LoadFontFile(xpf::string_viewex fontName)
+static bool IsEmpty(const std::shared_ptr<const MappedFile>& spFile)
 {
-    std::vector<byte_t> data = FileSystem::LoadFile(fontName);
-    if (!data.empty())
-        return data;
+    return spFile == nullptr || spFile->empty();
+}
+
+static std::shared_ptr<const MappedFile> LoadFontFile(xpf::string_viewex fontName)
+{
+    std::shared_ptr<const MappedFile> spFile = FileSystem::MapFile(fontName);
+    if (!IsEmpty(spFile))
+        return spFile;
 
     if (fontName.starts_with("/"))
-        return FileSystem::LoadFile(fontName);
+        return nullptr;
 
-    data = FileSystem::LoadFile("./bin/" + fontName);
-    if (!data.empty())
-        return data;
+    spFile = FileSystem::MapFile("./bin/" + fontName);
+    if (!IsEmpty(spFile))
+        return spFile;
 #if defined(PLATFORM_APPLE)
     std::string path = "/System/Library/Fonts/" + fontName;
-    data = FileSystem::LoadFile(path);
-    if (!data.empty())
-        return data;
+    spFile = FileSystem::MapFile(path);
+    if (!IsEmpty(spFile))
+        return spFile;
 
     path = "/System/Library/Fonts/Supplemental/" + fontName;
-    return FileSystem::LoadFile(path);
+    return FileSystem::MapFile(path);
 #elif defined(PLATFORM_WINDOWS)
     std::string path = "c:\\windows\\Fonts\\" + fontName;
-    return FileSystem::LoadFile(path);
+    return FileSystem::MapFile(path);
+#else
+    return nullptr;
 #endif
 }
 
-/*static*/ const std::shared_ptr<Font>& Font::GetFont(const Typeface& typeface)
+/*static*/ TypefaceId Font::GetTypefaceId(const Typeface& typeface)
+{
+    std::string key = typeface.name + " "
+        + std::to_string(typeface.size)
+        + "_"
+        + std::to_string(typeface.index)
+        + "_"
+        + std::to_string(uint32_t(typeface.renderOptions))
+        + (typeface.fixedFont ? "f" : "_");
+    const auto iter = s_typefaceIds.find(key);
+    if (iter != s_typefaceIds.cend())
+        return iter->second;
+
+    const TypefaceId id = TypefaceId(uint32_t(s_typefaces.size()));
+    s_typefaceIds.emplace(std::move(key), id);
+
+    // a font file that was never read gets loaded on a worker, the id serves the default font until then
+    const bool needsFileLoad =
+        s_loadInBackground &&
+        !typeface.name.empty() &&
+        !s_failedToLoadFonts.contains(typeface.name) &&
+        !s_loadedTrueTypeFile.contains(typeface.name) &&
+        !s_installedFonts.contains(GetInstalledFontKey(typeface));
+    if (needsFileLoad)
+    {
+        s_typefaces.push_back({typeface, GetDefaultFont()});
+        LoadFontInBackground(typeface, id, {});
+        return id;
+    }
+
+    s_typefaces.push_back({typeface, ResolveFont(typeface)});
+    return id;
+}
+
+/*static*/ std::string Font::GetInstalledFontKey(const Typeface& typeface)
+{
+    const bool isSizeIndependent =
+        typeface.renderOptions & FontRenderOptions::Shaded ||
+        typeface.renderOptions & FontRenderOptions::ShadedByTris ||
+        typeface.renderOptions & FontRenderOptions::DistanceField;
+    return typeface.name + " "
+        + std::to_string(isSizeIndependent ? 0 : typeface.size)
+        + "_"
+        + std::to_string(typeface.index)
+        + (typeface.renderOptions & FontRenderOptions::ShadedByTris ? "t" : (typeface.renderOptions & FontRenderOptions::DistanceField ? "d" : "_"))
+        + (typeface.renderOptions & FontRenderOptions::SizeInPixels ? "_p" : "_e");
+}
+
+/*static*/ Font::FontData Font::LoadFontData(const std::string& name)
+{
+    FontData fontData;
+    if (s_fontLoader != nullptr)
+    {
+        std::vector<byte_t> data = s_fontLoader(name);
+        if (!data.empty())
+            fontData.spFile = std::make_shared<const MappedFile>(std::move(data));
+    }
+
+    if (IsEmpty(fontData.spFile))
+        fontData.spFile = LoadFontFile(name + ".ttf");
+
+    if (IsEmpty(fontData.spFile))
+        fontData.spFile = LoadFontFile(name + ".ttc");
+
+    if (IsEmpty(fontData.spFile))
+    {
+        fontData.spFile = LoadFontFile(name + ".otf");
+        fontData.supportsLineShading = false;
+        fontData.supportsTriShading = false;
+    }
+
+    if (IsEmpty(fontData.spFile))
+        fontData.spFile = nullptr;
+    else if (GlyphCache::IsEnabled())
+        fontData.contentHash = GlyphCache::HashContent(fontData.spFile->data(), fontData.spFile->size());
+
+    return fontData;
+}
+
+/*static*/ const std::shared_ptr<Font>& Font::ResolveFont(const Typeface& typeface)
 {
     if (s_failedToLoadFonts.find(typeface.name) != s_failedToLoadFonts.end())
         return Font::GetDefaultFont();
@@ -969,59 +1308,146 @@ static std::vector<byte_t> LoadFontFile(xpf::string_viewex fontName)
     if (typeface.name.empty())
         return Font::GetDefaultFont();
 
-    std::string lookup = typeface.name + " "
-        + std::to_string(typeface.renderOptions & FontRenderOptions::Shaded || typeface.renderOptions & FontRenderOptions::ShadedByTris ? 0 : typeface.size)
-        + "_"
-        + std::to_string(typeface.index)
-        + (typeface.renderOptions & FontRenderOptions::ShadedByTris ? "t" : "_")
-        + (typeface.renderOptions & FontRenderOptions::SizeInPixels ? "_p" : "_e");
+    std::string lookup = GetInstalledFontKey(typeface);
     const auto iter = s_installedFonts.find(lookup);
     if (iter != s_installedFonts.cend())
         return iter->second;
 
     if (s_loadedTrueTypeFile.contains(typeface.name))
     {
-        const std::shared_ptr<xpf::Font> spFont = Font::LoadFont(typeface);
+        const std::shared_ptr<xpf::Font> spFont = Font::LoadFont(typeface, s_loadedTrueTypeFile[typeface.name]);
         if (spFont != nullptr)
         {
+            spFont->m_loadPagesInBackground = s_loadInBackground;
             s_installedFonts[lookup] = spFont;
             return s_installedFonts[lookup];
         }
     }
 
-    FontData fontData;
-    if (s_fontLoader != nullptr)
-        fontData.data = s_fontLoader(typeface.name);
+    FontData fontData = LoadFontData(typeface.name);
+    if (fontData.spFile != nullptr)
+    {
+        const std::shared_ptr<xpf::Font> spFont = Font::LoadFont(typeface, fontData);
+        s_loadedTrueTypeFile[typeface.name] = std::move(fontData);
+        if (spFont != nullptr)
+        {
+            spFont->m_loadPagesInBackground = s_loadInBackground;
+            s_installedFonts[lookup] = spFont;
+            return s_installedFonts[lookup];
+        }
+    }
+    else
+    {
+        s_failedToLoadFonts.insert(typeface.name);
+    }
 
-    if (fontData.data.empty())
-        fontData.data = LoadFontFile(typeface.name + ".ttf");
+    return Font::GetDefaultFont();
+}
 
-    if (fontData.data.empty())
-        fontData.data = LoadFontFile(typeface.name + ".ttc");
+/*static*/ void Font::Prefetch(const Typeface& typeface, const std::vector<CodepointRange>& ranges)
+{
+    if (typeface.name.empty() || s_failedToLoadFonts.contains(typeface.name))
+        return;
 
-    if (fontData.data.empty())
+    const auto iter = s_installedFonts.find(GetInstalledFontKey(typeface));
+    if (iter == s_installedFonts.cend())
     {
-        fontData.data = LoadFontFile(typeface.name + ".otf");
-        fontData.supportsLineShading = false;
-        fontData.supportsTriShading = false;
+        LoadFontInBackground(typeface, TypefaceId::NotSet, ranges);
+        return;
     }
 
-    if (!fontData.data.empty())
+    // pages loaded already render their glyphs on first use
+    const Font& font = *iter->second;
+    for (const CodepointRange& range : ranges)
     {
-        s_loadedTrueTypeFile[typeface.name] = std::move(fontData);
+        for (uint32_t pageIndex = range.first / font.m_pageSize; pageIndex <= range.last / font.m_pageSize; pageIndex++)
+        {
+            if (pageIndex >= font.m_pages.size() || font.m_pages[pageIndex] == nullptr)
+                font.LoadPageInBackground(pageIndex, ranges);
+        }
+    }
+}
+
+/*static*/ void Font::LoadFontInBackground(const Typeface& typeface, TypefaceId id, const std::vector<CodepointRange>& ranges)
+{
+    const std::string key = GetInstalledFontKey(typeface);
+    auto [iter, isFirstRequest] = s_loadingFonts.try_emplace(key);
+    if (id != TypefaceId::NotSet)
+        iter->second.push_back(id);
+    if (!isFirstRequest)
+        return;
+
+    // the file bytes are shared, one loaded earlier is parsed on the worker as is
+    const auto fileIter = s_loadedTrueTypeFile.find(typeface.name);
+    FontData loadedData = fileIter != s_loadedTrueTypeFile.cend() ? fileIter->second : FontData{};
+
+    FontLoader::Enqueue([typeface, key, ranges, loadedData]()
+    {
+        auto spFontData = std::make_shared<FontData>(loadedData);
+        if (spFontData->spFile == nullptr)
+            *spFontData = LoadFontData(typeface.name);
+
+        std::shared_ptr<Font> spFont;
+        auto spPages = std::make_shared<std::vector<LoadedPage>>();
+        if (spFontData->spFile != nullptr)
+            spFont = LoadFont(typeface, *spFontData);
 
-        const std::shared_ptr<xpf::Font> spFont = Font::LoadFont(typeface);
         if (spFont != nullptr)
         {
-            s_installedFonts[lookup] = spFont;
-            return s_installedFonts[lookup];
+            std::vector<uint32_t> pageIndices{0};
+            for (const CodepointRange& range : ranges)
+            {
+                for (uint32_t pageIndex = range.first / spFont->m_pageSize; pageIndex <= range.last / spFont->m_pageSize; pageIndex++)
+                    pageIndices.push_back(pageIndex);
+            }
+
+            std::sort(pageIndices.begin(), pageIndices.end());
+            pageIndices.erase(std::unique(pageIndices.begin(), pageIndices.end()), pageIndices.end());
+            for (const uint32_t pageIndex : pageIndices)
+                spPages->push_back(spFont->BuildPage(pageIndex, ranges));
         }
+
+        FontLoader::Dispatch([typeface, key, spFontData, spFont, spPages]()
+        {
+            InstallFont(typeface, key, std::move(*spFontData), spFont, std::move(*spPages));
+        });
+    });
+}
+
+/*static*/ void Font::InstallFont(const Typeface& typeface, const std::string& key, FontData&& fontData, std::shared_ptr<Font> spFont, std::vector<LoadedPage>&& pages)
+{
+    std::vector<TypefaceId> waitingIds;
+    if (auto node = s_loadingFonts.extract(key); !node.empty())
+        waitingIds = std::move(node.mapped());
+
+    // the parsed font holds on to its own file, whichever copy stays here does not matter
+    if (fontData.spFile != nullptr && !s_loadedTrueTypeFile.contains(typeface.name))
+        s_loadedTrueTypeFile[typeface.name] = std::move(fontData);
+
+    const auto installed = s_installedFonts.find(key);
+    if (installed != s_installedFonts.cend())
+    {
+        spFont = installed->second;
+    }
+    else if (spFont != nullptr)
+    {
+        spFont->m_loadPagesInBackground = s_loadInBackground;
+        s_installedFonts[key] = spFont;
+    }
+    else
+    {
+        if (!s_loadedTrueTypeFile.contains(typeface.name))
+            s_failedToLoadFonts.insert(typeface.name);
+        return; // waiting ids keep the default font
     }
 
-    if (fontData.data.empty())
-        s_failedToLoadFonts.insert(typeface.name);
+    for (LoadedPage& page : pages)
+        spFont->InstallPage(std::move(page));
 
-    return Font::GetDefaultFont();
+    for (const TypefaceId id : waitingIds)
+        s_typefaces[uint32_t(id)].spFont = spFont;
+
+    s_epoch++;
 }
 
 #pragma region vector font
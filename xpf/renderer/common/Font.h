@@ -1,16 +1,21 @@
 #pragma once
 #include <stdint.h>
+#include <deque>
 #include <string>
 #include <functional>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <core/Rectangle.h>
 #include <core/Size.h>
 #include <core/Macros.h>
 #include <renderer/IBuffer.h>
 #include <renderer/ITexture.h>
+#include <renderer/common/GlyphAtlas.h>
+#include <renderer/common/GlyphCache.h>
+#include <renderer/common/KerningTable.h>
 
 namespace xpf {
 
@@ -20,6 +25,7 @@ enum class FontRenderOptions
     Shaded  = 0x1,
     ShadedByTris = 0x2,
     SizeInPixels = 0x4,
+    DistanceField = 0x8, // texture rendered from a signed distance field, one atlas serves every size
 };
 ENUM_CLASS_FLAG_OPERATORS(FontRenderOptions);
 
@@ -47,6 +53,19 @@ inline bool operator!=(const Typeface& t1,const Typeface& t2) {
     return !(t1 == t2);
 }
 
+// Inclusive range of codepoints, e.g. {0x20, 0x7e} for printable ASCII
+struct CodepointRange
+{
+    char32_t first = 0;
+    char32_t last = 0;
+};
+
+// Handle of a resolved Typeface, see Font::GetTypefaceId. Equal typefaces get the same id.
+enum class TypefaceId : uint32_t
+{
+    NotSet,
+};
+
 struct Codepoint
 {
     int32_t glyphindex = 0;
@@ -58,13 +77,43 @@ struct Codepoint
     float advance = 0;
     rectf_t texCoords;
     uint32_t glyphStartOffset = 0; // start offset in number of 'short's
+    GlyphAtlasSlot atlasSlot;      // texture rendered glyphs live in the shared glyph atlas
+    bool needsRasterization = false; // metrics are known, bitmap/outline is not built yet
 };
 
+// Codepoints of one page stored densely, indexed by codepoint % page size,
+// with a bitmap telling which slots were filled in.
 struct CodepointPage
 {
     std::shared_ptr<xpf::ITexture> spTexture;
     std::shared_ptr<xpf::IBuffer> spBuffer;
-    std::unordered_map<uint32_t, Codepoint> codepoints;
+    std::vector<Codepoint> codepoints;
+    std::vector<uint64_t> presence;
+    std::vector<int16_t> outlines; // shader rendered glyph data, uploaded to spBuffer by Font::CommitPage
+    bool isBufferDirty = false;
+
+    bool IsEmpty() const { return codepoints.empty(); }
+
+    void Resize(uint32_t pageSize)
+    {
+        codepoints.resize(pageSize);
+        presence.resize((pageSize + 63) / 64);
+    }
+
+    void Set(uint32_t index, Codepoint&& codepoint)
+    {
+        codepoints[index] = std::move(codepoint);
+        presence[index / 64] |= uint64_t(1) << (index % 64);
+    }
+
+    Codepoint* Find(uint32_t index)
+    {
+        if (index >= codepoints.size() || !(presence[index / 64] & (uint64_t(1) << (index % 64)))) [[unlikely]]
+            return nullptr;
+        return &codepoints[index];
+    }
+
+    const Codepoint* Find(uint32_t index) const { return const_cast<CodepointPage*>(this)->Find(index); }
 };
 
 struct FontMetrics
@@ -86,12 +135,31 @@ class Font
 protected:
     struct FontData
     {
-        std::vector<byte_t> data;
+        std::shared_ptr<const MappedFile> spFile; // null when the font was not found
+        uint64_t contentHash = 0; // set when glyph caching is on, see GlyphCache
         bool supportsLineShading = true;
         bool supportsTriShading = true;
         bool supportsTextureShading = true;
     };
 
+    // bitmap of a texture rendered glyph, rendered on a worker and placed into the atlas on the UI thread
+    struct GlyphBitmap
+    {
+        uint32_t index = 0; // codepoint index within its page
+        int32_t width = 0;
+        int32_t height = 0;
+        int32_t xoffset = 0;
+        int32_t yoffset = 0;
+        std::vector<byte_t> pixels;
+    };
+
+    struct LoadedPage
+    {
+        uint32_t pageIndex = 0;
+        CodepointPage page;
+        std::vector<GlyphBitmap> bitmaps = {};
+    };
+
     struct HideConstructor { };
     Font() = default;
 
@@ -103,39 +171,151 @@ protected:
     bool m_supportsLineShading = true;
     bool m_supportsTriShading = true;
     bool m_supportsTextureShading = true;
+    bool m_usesGlyphAtlas = false;
+    bool m_isDistanceField = false;
+    bool m_loadPagesInBackground = false;
     float m_scale = 1.0;
 
-    mutable std::unordered_map<uint32_t, CodepointPage> m_pages;
+    // indexed by codepoint / m_pageSize, loaded on first use; pages never move once loaded
+    mutable std::vector<std::unique_ptr<CodepointPage>> m_pages;
+    mutable CodepointPage* m_pAsciiPage = nullptr; // page 0, pinned for the common 0-127 range
+    mutable std::unordered_set<uint32_t> m_loadingPages; // pages being built on a worker
     std::shared_ptr<FontInfo> m_spFontInfo;
+    KerningTable m_kerning;
+    std::shared_ptr<GlyphCache> m_spGlyphCache; // glyphs built by earlier runs, null when caching is off
     static constexpr uint32_t c_pageSize = 128;
+    static constexpr uint32_t c_asciiRange = 128;         // codepoints served straight from m_pAsciiPage
+    static_assert(c_asciiRange <= c_pageSize);
+    static constexpr uint16_t c_distanceFieldSize = 48;   // size distance field glyphs are rasterized at
+    static constexpr int32_t c_distanceFieldPadding = 6;  // pixels of distance kept around each glyph
+    static constexpr size_t c_minParallelGlyphs = 8;      // fewer outlines are built on the calling thread
 
     static inline std::function<std::vector<byte_t>(std::string_view)> s_fontLoader;
     static inline std::unordered_map<std::string, FontData> s_loadedTrueTypeFile;
     static inline std::unordered_map<std::string, std::shared_ptr<xpf::Font>> s_installedFonts;
     static inline std::unordered_set<std::string> s_failedToLoadFonts;
+    static inline std::unordered_map<std::string, std::vector<TypefaceId>> s_loadingFonts; // installed font key -> ids waiting for it
+    static inline bool s_loadInBackground = false;
+    static inline uint32_t s_epoch = 0;
+
+    struct TypefaceEntry
+    {
+        Typeface typeface; // as requested
+        std::shared_ptr<xpf::Font> spFont;
+    };
+    // indexed by TypefaceId, deque keeps references stable while ids get added
+    static inline std::deque<TypefaceEntry> s_typefaces = std::deque<TypefaceEntry>(1);
+    static inline std::unordered_map<std::string, TypefaceId> s_typefaceIds;
 
 public:
     explicit Font(HideConstructor) {}
 
+    // with background loading the font loader is called on worker threads
     static void SetFontLoader(std::function<std::vector<byte_t>(std::string_view)>&& fn) { s_fontLoader = std::move(fn); }
 
-    static const std::shared_ptr<Font>& GetFont(const Typeface& typeface);
+    // Fonts and codepoint pages that are not loaded yet get loaded on worker threads (see FontLoader)
+    // instead of blocking the frame; until they arrive text renders with the glyphs at hand.
+    static void SetLoadInBackground(bool value) { s_loadInBackground = value; }
+
+    // loads the typeface and renders the glyphs of the ranges on worker threads, e.g. at startup
+    static void Prefetch(const Typeface& typeface, const std::vector<CodepointRange>& ranges = {{0x20, 0x7e}});
+
+    // Glyph metrics, outlines and bitmaps are kept in directory between runs, by default the per-user
+    // cache directory (see GlyphCache::GetDefaultDirectory); an empty directory turns caching off. Set it
+    // before the first font loads; SaveGlyphCaches writes what this run built (renderers call it on Shutdown).
+    static void SetGlyphCacheDirectory(std::string_view directory) { GlyphCache::SetDirectory(directory); }
+    static void SaveGlyphCaches();
+
+    // changes whenever a background load lands, text laid out before may have used fallback glyphs
+    static uint32_t GetEpoch() { return s_epoch; }
+
+    static const std::shared_ptr<Font>& GetFont(const Typeface& typeface) { return GetFont(GetTypefaceId(typeface)); }
     static const std::shared_ptr<Font>& GetDefaultFont();
 
+    // resolves (and loads) the typeface once, later lookups by id are a single index
+    static TypefaceId GetTypefaceId(const Typeface& typeface);
+    static const std::shared_ptr<Font>& GetFont(TypefaceId id)
+    {
+        const uint32_t index = uint32_t(id);
+        if (index == 0 || index >= s_typefaces.size()) [[unlikely]]
+            return GetDefaultFont();
+        return s_typefaces[index].spFont;
+    }
+    static const Typeface& GetTypeface(TypefaceId id)
+    {
+        const uint32_t index = uint32_t(id);
+        return index < s_typefaces.size() ? s_typefaces[index].typeface : s_typefaces[0].typeface;
+    }
+
     const Typeface& GetTypeface() const { return m_typeface; }
     const FontMetrics& GetMetrics() const { return m_metrics; }
+    bool IsDistanceField() const { return m_isDistanceField; }
+    // empty pixels on each side of a glyph bitmap, in font pixels
+    float GetGlyphPadding() const { return m_isDistanceField ? float(c_distanceFieldPadding) : 0.0f; }
     float GetScale(int16_t fontSize) const;
     void ForEachCodepoint(std::string_view text, std::function<void(char32_t, const CodepointPage&, const Codepoint&, float kern)>&& fn);
     const CodepointPage& GetCodepointPage(uint32_t ch) const;
     const std::pair<CodepointPage&, const Codepoint&> GetCodepoint(char32_t ch) const;
-    int32_t GetKern(char32_t ch1, char32_t ch2) const;
+    int32_t GetKern(uint32_t glyph1, uint32_t glyph2) const { return m_kerning.Get(glyph1, glyph2); }
     SizeF Measure(std::string_view text) const;
 
+    static const std::shared_ptr<xpf::ITexture>& GetTexture(const CodepointPage& page, const Codepoint& codepoint)
+    {
+        return codepoint.atlasSlot.IsAllocated() ? GlyphAtlas::GetTexture(codepoint.atlasSlot) : page.spTexture;
+    }
+
+    static rectf_t GetTexCoords(const Codepoint& codepoint)
+    {
+        return codepoint.atlasSlot.IsAllocated() ? GlyphAtlas::GetTexCoords(codepoint.atlasSlot) : codepoint.texCoords;
+    }
+
 protected:
+    void RasterizeGlyph(Codepoint& codepoint) const { PlaceGlyphBitmap(codepoint, RenderGlyphBitmap(codepoint)); }
+    GlyphBitmap RenderGlyphBitmap(const Codepoint& codepoint) const;
+    void PlaceGlyphBitmap(Codepoint& codepoint, const GlyphBitmap& bitmap) const;
+    void RasterizeGlyph(CodepointPage& page, Codepoint& codepoint) const;
+    void RasterizeGlyphs(std::vector<std::pair<CodepointPage*, Codepoint*>>& glyphs) const; // in parallel, appended in codepoint order
+    void BuildGlyphShape(const Codepoint& codepoint, std::vector<int16_t>& shape) const;
+    void BuildGlyphTriangles(const Codepoint& codepoint, std::vector<int16_t>& tris) const;
+    void BuildGlyphOutline(const Codepoint& codepoint, std::vector<int16_t>& points) const;
+    void CommitPage(CodepointPage& page) const; // uploads outlines appended since the last commit
+    void SaveGlyphCache() const;
+
+    // glyphs are rasterized (or triangulated) the first time they are used, not when their page loads
+    void EnsureRasterized(CodepointPage& page, Codepoint& codepoint) const
+    {
+        if (codepoint.needsRasterization) [[unlikely]]
+            RasterizeGlyph(page, codepoint);
+
+        if (!m_usesGlyphAtlas)
+            return;
+
+        // glyph got evicted from the atlas, render it again
+        if (codepoint.atlasSlot.IsAllocated() && !GlyphAtlas::IsValid(codepoint.atlasSlot)) [[unlikely]]
+            RasterizeGlyph(codepoint);
+
+        GlyphAtlas::Touch(codepoint.atlasSlot);
+    }
+
+    CodepointPage* FindPage(uint32_t pageIndex) const
+    {
+        if (pageIndex < m_pages.size() && m_pages[pageIndex] != nullptr) [[likely]]
+            return m_pages[pageIndex].get();
+        return LoadPageOnDemand(pageIndex);
+    }
+
+    CodepointPage* LoadPageOnDemand(uint32_t pageIndex) const;
     CodepointPage LoadPage(uint32_t pageIndex) const;
-    CodepointPage LoadPageForShadedTris(uint32_t pageIndex) const;
+    LoadedPage BuildPage(uint32_t pageIndex, const std::vector<CodepointRange>& ranges) const; // safe on workers
+    void LoadPageInBackground(uint32_t pageIndex, const std::vector<CodepointRange>& ranges) const;
+    void InstallPage(LoadedPage&& loaded) const;
     static std::shared_ptr<Font> LoadDefaultFont();
-    static std::shared_ptr<Font> LoadFont(const Typeface& typeface);
+    static std::shared_ptr<Font> LoadFont(const Typeface& typeface, const FontData& fontData);
+    static FontData LoadFontData(const std::string& name);
+    static std::string GetInstalledFontKey(const Typeface& typeface);
+    static const std::shared_ptr<Font>& ResolveFont(const Typeface& typeface);
+    static void LoadFontInBackground(const Typeface& typeface, TypefaceId id, const std::vector<CodepointRange>& ranges);
+    static void InstallFont(const Typeface& typeface, const std::string& key, FontData&& fontData, std::shared_ptr<Font> spFont, std::vector<LoadedPage>&& pages);
 };
 
 } // xpf
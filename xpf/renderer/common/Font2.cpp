@@ -5,6 +5,7 @@
 #include <core/Log.h>
 #include <core/FileSystem.h>
 #include <core/stringex.h>
+#include <renderer/common/KerningTable.h>
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #pragma clang diagnostic push
@@ -67,6 +68,7 @@ namespace xpf {
 struct Font2::FontInfo2
 {
     stbtt_fontinfo info;
+    KerningTable kerning;
     std::unordered_map<uint32_t, CodepointPage2> pages;
     uint32_t pageSize = 128;
     int16_t descent = 0;
@@ -111,12 +113,13 @@ struct Font2::FontInfo2
         fontHeight = vascent - vdescent;
         lineHeight = fontHeight + vlineGap;
         lineGap = vlineGap;
+        kerning.Build(info);
         return true;
     }
 
     int32_t GetKern(uint32_t g1, uint32_t g2) const
     {
-        return stbtt__GetGlyphKernInfoAdvance(&info, g1, g2);
+        return kerning.Get(g1, g2);
     }
 
     auto GetPageIter(uint32_t pageIndex)
@@ -657,16 +660,14 @@ void Font2::ForEachCodepoint(
 
     uint32_t currentPageIndex = UINT32_MAX;
     auto pageIter = m_spFontInfo->pages.end();
-    const size_t length = text.length();
     uint32_t prevGlyphIndex = 0;
 
-    size_t i = 0;
-    while (i < length)
+    std::vector<char32_t> decoded;
+    stringex::utf8_to_utf32(text, decoded);
+
+    for (const char32_t ch : decoded)
     {
-        char32_t ch = stringex::utf8_to_utf32(text, i);
-        if (ch == 0) [[unlikely]]
-            break;
-        else if (ch == '\n') [[unlikely]]
+        if (ch == '\n') [[unlikely]]
              prevGlyphIndex = 0;
 
         uint32_t pageIndex = ch / m_spFontInfo->pageSize;
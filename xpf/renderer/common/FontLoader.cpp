@@ -0,0 +1,158 @@
+#include "FontLoader.h"
+#include <core/FrameScheduler.h>
+#include <core/Log.h>
+#include <algorithm>
+#include <atomic>
+
+namespace xpf {
+
+/*static*/ void FontLoader::EnsureStarted()
+{
+    // joins the workers before the statics they use go away
+    struct Workers
+    {
+        std::vector<std::thread> threads;
+
+        Workers()
+        {
+            const uint32_t hardwareThreads = std::max(2u, std::thread::hardware_concurrency());
+            const uint32_t count = std::min(c_maxWorkers, hardwareThreads - 1);
+            for (uint32_t i = 0; i < count; i++)
+                threads.emplace_back(&FontLoader::RunWorker);
+            s_workerCount = count;
+        }
+
+        ~Workers()
+        {
+            {
+                std::lock_guard<std::mutex> lock(s_mutex);
+                s_shutdown = true;
+                s_work.clear();
+            }
+            s_workAvailable.notify_all();
+            for (auto& thread : threads)
+                thread.join();
+        }
+    };
+
+    static Workers s_workers;
+}
+
+/*static*/ void FontLoader::Enqueue(std::function<void()>&& fn)
+{
+    EnsureStarted();
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (s_shutdown)
+            return;
+        s_work.push_back(std::move(fn));
+    }
+    s_workAvailable.notify_one();
+}
+
+/*static*/ void FontLoader::Dispatch(std::function<void()>&& fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (s_shutdown)
+            return;
+        s_completed.push_back(std::move(fn));
+    }
+    FrameScheduler::RequestFrame();
+}
+
+/*static*/ bool FontLoader::RunCompleted()
+{
+    std::vector<std::function<void()>> completed;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (s_completed.empty()) [[likely]]
+            return false;
+        completed.swap(s_completed);
+    }
+
+    for (auto& fn : completed)
+    {
+        try {
+            fn();
+        } catch (const std::exception& e) {
+            Log::error(std::string("FontLoader: ") + e.what());
+        }
+    }
+
+    return true;
+}
+
+/*static*/ void FontLoader::ParallelFor(size_t count, const std::function<void(size_t)>& fn)
+{
+    // outlives the call when a helper gets to run after all items are taken
+    struct Shared
+    {
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> done = 0;
+        size_t count = 0;
+        const std::function<void(size_t)>* pfn = nullptr;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    if (count < 2)
+    {
+        for (size_t i = 0; i < count; i++)
+            fn(i);
+        return;
+    }
+
+    auto spShared = std::make_shared<Shared>();
+    spShared->count = count;
+    spShared->pfn = &fn;
+
+    // fn is only touched for an item taken before the caller saw all items done
+    auto run = [](Shared& shared)
+    {
+        size_t ran = 0;
+        for (size_t i = shared.next++; i < shared.count; i = shared.next++, ran++)
+            (*shared.pfn)(i);
+
+        if (ran != 0 && (shared.done += ran) == shared.count)
+        {
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            shared.finished.notify_all();
+        }
+    };
+
+    EnsureStarted();
+    const size_t helpers = std::min<size_t>(s_workerCount, count - 1);
+    for (size_t i = 0; i < helpers; i++)
+        Enqueue([spShared, run]() { run(*spShared); });
+
+    run(*spShared);
+
+    std::unique_lock<std::mutex> lock(spShared->mutex);
+    spShared->finished.wait(lock, [&]() { return spShared->done == count; });
+}
+
+/*static*/ void FontLoader::RunWorker()
+{
+    for (;;)
+    {
+        std::function<void()> fn;
+        {
+            std::unique_lock<std::mutex> lock(s_mutex);
+            s_workAvailable.wait(lock, []() { return s_shutdown || !s_work.empty(); });
+            if (s_shutdown)
+                return;
+
+            fn = std::move(s_work.front());
+            s_work.pop_front();
+        }
+
+        try {
+            fn();
+        } catch (const std::exception& e) {
+            Log::error(std::string("FontLoader: ") + e.what());
+        }
+    }
+}
+
+} // xpf
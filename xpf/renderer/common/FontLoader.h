@@ -0,0 +1,48 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xpf {
+
+// Small pool of worker threads for font file loading, parsing and glyph rasterization.
+// Work runs off the UI thread and hands its results back with Dispatch; RunCompleted
+// applies them on the UI thread, renderers call it once per frame before drawing.
+class FontLoader
+{
+protected:
+    static constexpr uint32_t c_maxWorkers = 8;
+
+    static inline uint32_t s_workerCount = 0;
+
+    static inline std::mutex s_mutex;
+    static inline std::condition_variable s_workAvailable;
+    static inline std::deque<std::function<void()>> s_work;
+    static inline std::vector<std::function<void()>> s_completed;
+    static inline bool s_shutdown = false;
+
+public:
+    FontLoader() = delete;
+
+    // runs fn on a worker thread, the pool is started on first use
+    static void Enqueue(std::function<void()>&& fn);
+
+    // queues fn to run on the UI thread with the next RunCompleted, callable from any thread
+    static void Dispatch(std::function<void()>&& fn);
+
+    // UI thread: runs everything dispatched since the last call, returns whether anything ran
+    static bool RunCompleted();
+
+    // runs fn(i) for every i in [0, count) on the workers and the calling thread, returns once all ran.
+    // the caller takes items itself, so it is safe on a worker and with every worker busy; fn must not throw
+    static void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+protected:
+    static void EnsureStarted();
+    static void RunWorker();
+};
+
+} // xpf
@@ -1,5 +1,6 @@
 #include "FormattedText.h"
 #include "RenderBatchBuilder.h"
+#include <algorithm>
 
 namespace xpf {
 
@@ -25,21 +26,40 @@ FormattedText::FormattedText(
 
 const Glyph& FormattedText::GetEllipsisGlyph()
 {
-    if (m_isGeometryBuilt)
-        BuildGeometry();
-
+    BuildGeometry();
     return m_ellipsisGlyph;
 }
 
 const std::vector<FormattedLine>& FormattedText::GetLines()
 {
-    if (m_isGeometryBuilt)
-        BuildGeometry();
-
+    BuildGeometry();
     return m_lines;
 }
 
-void FormattedLine::AddGlyph(Glyph&& gIn, float kern)
+void FormattedLine::AppendGlyph(const Glyph& g, const std::shared_ptr<ITexture>& spTexture)
+{
+    // compares pointers, the texture is only copied when a new run starts
+    if (runs.empty() || runs.back().spTexture != spTexture)
+        runs.push_back({spTexture, uint32_t(glyphs.size()), 0});
+
+    runs.back().glyphCount++;
+    glyphs.push_back(g);
+}
+
+void FormattedLine::Truncate(size_t glyphCount)
+{
+    if (glyphCount >= glyphs.size())
+        return;
+
+    glyphs.erase(glyphs.begin() + glyphCount, glyphs.cend());
+    while (!runs.empty() && runs.back().firstGlyph >= glyphCount)
+        runs.pop_back();
+
+    if (!runs.empty())
+        runs.back().glyphCount = uint32_t(glyphCount) - runs.back().firstGlyph;
+}
+
+void FormattedLine::AddGlyph(const Glyph& gIn, const std::shared_ptr<ITexture>& spTexture, float kern)
 {
     if (glyphs.empty())
     {
@@ -51,7 +71,8 @@ void FormattedLine::AddGlyph(Glyph&& gIn, float kern)
         glyphs.back().advance_x += kern;
     }
 
-    Glyph& g = glyphs.emplace_back(std::move(gIn));
+    AppendGlyph(gIn, spTexture);
+    const Glyph& g = glyphs.back();
     if (g.is_newline())
         return;
 
@@ -65,10 +86,7 @@ void FormattedText::FinalizeLineCalculations(FormattedLine& line)
 {
     float x = 0;
     float bounds_x = line.lineWidth;
-    float leftBearing = 0;
-    if (!line.glyphs.empty())
-        leftBearing = line.glyphs.front().bearing_x;
-    
+
     if (line.glyphs.size() >= 1)
     {
         line.lineWidth -= line.glyphs.front().bearing_x;
@@ -83,13 +101,11 @@ void FormattedText::FinalizeLineCalculations(FormattedLine& line)
             float newx = line.glyphs[i].advance_to_right(x);
             if (newx > m_maxWidth - m_ellipsisWidth)
             {
-                line.glyphs[i].is_over_budget = true;
-                line.glyphs.erase(line.glyphs.begin() + i, line.glyphs.cend());
-                const Glyph ellipsis_glyph = GetEllipsisGlyph();
-                line.glyphs.push_back(ellipsis_glyph);
-                if (ellipsis_glyph.ch == '.') {
-                    line.glyphs.push_back(ellipsis_glyph);
-                    line.glyphs.push_back(ellipsis_glyph);
+                line.Truncate(i);
+                line.AppendGlyph(m_ellipsisGlyph, m_spEllipsisTexture);
+                if (m_ellipsisGlyph.ch == '.') {
+                    line.AppendGlyph(m_ellipsisGlyph, m_spEllipsisTexture);
+                    line.AppendGlyph(m_ellipsisGlyph, m_spEllipsisTexture);
                 }
                 break;
             }
@@ -101,44 +117,97 @@ void FormattedText::FinalizeLineCalculations(FormattedLine& line)
         }
     }
 
-    m_bounds.x = std::max(m_bounds.x, bounds_x);
+    line.boundsX = bounds_x;
+}
 
-    m_width = std::max(line.lineWidth, m_width);
-    m_widthIncludingTrailingspaces = std::max(line.lineWidthIncludingTrailingspaces, m_widthIncludingTrailingspaces);
+void FormattedText::UpdateTextMetrics()
+{
+    // folds the per line results, no glyph is looked at
+    m_width = 0;
+    m_widthIncludingTrailingspaces = 0;
+    m_height = 0;
+    m_minHeight = 0;
+    m_bounds = v2_t(0);
+    m_boundsNoBearings = v2_t(0);
 
-    if (m_lineHeight + m_height <= m_maxHeight + math::Epsilon  && m_lines.size() < m_maxLineCount)
+    for (size_t i = 0; i < m_lines.size(); i++)
     {
-        m_height += m_lineHeight + m_advanceNewlineY;
-        m_bounds.y = m_height;
-    }
-    else
-    {
-        line.isOverBudgetY = true;
+        FormattedLine& line = m_lines[i];
+        m_bounds.x = std::max(m_bounds.x, line.boundsX);
+        m_width = std::max(line.lineWidth, m_width);
+        m_widthIncludingTrailingspaces = std::max(line.lineWidthIncludingTrailingspaces, m_widthIncludingTrailingspaces);
+
+        line.isOverBudgetY = !(m_lineHeight + m_height <= m_maxHeight + math::Epsilon && i + 1 < m_maxLineCount);
+        if (!line.isOverBudgetY)
+        {
+            m_height += m_lineHeight + m_advanceNewlineY;
+            m_bounds.y = m_height;
+        }
+
+        m_boundsNoBearings.x = std::max(m_boundsNoBearings.x, line.boundsX + line.leftBearingX);
+        m_minHeight += m_lineHeight;
     }
 
-    m_boundsNoBearings.x = std::max(m_boundsNoBearings.x, bounds_x + leftBearing);
     m_boundsNoBearings.y = m_bounds.y;
+}
 
-    m_minHeight += m_lineHeight;
+void FormattedText::ShapeLines(uint32_t textOffset, uint32_t textLength, bool isEndOfText, std::vector<FormattedLine>& lines)
+{
+    const float scale = m_spFont->GetScale(m_typeface.size);
+    FormattedLine* pline = &lines.emplace_back();
+
+    m_spFont->ForEachCodepoint(std::string_view(m_text).substr(textOffset, textLength), [&](char32_t ch, const CodepointPage& page, const Codepoint& codepoint, float kern)
+    {
+        pline->AddGlyph(Glyph(ch, codepoint, scale), Font::GetTexture(page, codepoint), kern * scale);
+
+        if (is_newline(ch))
+            pline = &lines.emplace_back();
+    });
+
+    // a range that stops short of the last line ends in a '\n', the line after it is already there
+    if (!isEndOfText && lines.size() > 1 && lines.back().glyphs.empty())
+        lines.pop_back();
+
+    const uint32_t textEnd = textOffset + textLength;
+
+    uint32_t lineStart = textOffset;
+    for (FormattedLine& line : lines)
+    {
+        const size_t newline = m_text.find('\n', lineStart);
+        const uint32_t lineEnd = (newline == std::string::npos || newline >= textEnd) ? textEnd : uint32_t(newline + 1);
+        line.textOffset = lineStart;
+        line.textLength = lineEnd - lineStart;
+        lineStart = lineEnd;
+
+        FinalizeLineCalculations(line);
+    }
 }
 
 void FormattedText::BuildGeometry()
 {
-    if (m_isGeometryBuilt)
+    // glyph atlas grew or evicted a sheet, texture coordinates need to be picked up again;
+    // a font or page loaded in the background replaces the placeholder glyphs
+    if (m_isGeometryBuilt && m_atlasEpoch == GlyphAtlas::GetEpoch() && m_fontEpoch == Font::GetEpoch()) [[likely]]
         return;
 
     m_isGeometryBuilt = true;
+    m_atlasEpoch = GlyphAtlas::GetEpoch();
+    m_fontEpoch = Font::GetEpoch();
 
     m_lines.clear();
 
-    m_spFont = Font::GetFont(m_typeface);
+    if (m_typefaceId == TypefaceId::NotSet)
+        m_typefaceId = Font::GetTypefaceId(m_typeface);
+
+    m_spFont = Font::GetFont(m_typefaceId);
     const float scale = m_spFont->GetScale(m_typeface.size);
     const auto& metrics = m_spFont->GetMetrics();
     m_lineHeight = metrics.lineHeight * scale;
     m_baseline = metrics.baseline * scale;
     m_advanceNewlineX = metrics.advanceNewlineX * scale;
     m_advanceNewlineY = metrics.advanceNewlineY * scale;
-    m_bounds = v2_t(0);
+    m_glyphPadding = m_spFont->GetGlyphPadding() * scale;
+    m_isDistanceField = m_spFont->IsDistanceField();
 
     if (m_textTrimming == TextTrimming::None)
     {
@@ -147,38 +216,69 @@ void FormattedText::BuildGeometry()
     else
     {
         auto ci = m_spFont->GetCodepoint(0x2026);
-        if (ci.first.spTexture == nullptr)
+        if (ci.first.IsEmpty())
         {
             auto ci2 = m_spFont->GetCodepoint('.');
-            m_ellipsisGlyph = Glyph('.', ci2.first.spTexture, ci2.second, scale);
+            m_ellipsisGlyph = Glyph('.', ci2.second, scale);
+            m_spEllipsisTexture = Font::GetTexture(ci2.first, ci2.second);
             m_ellipsisWidth = m_ellipsisGlyph.advance_x * 3;
         }
         else
         {
-            m_ellipsisGlyph = Glyph(0x2026, ci.first.spTexture, ci.second, scale);
+            m_ellipsisGlyph = Glyph(0x2026, ci.second, scale);
+            m_spEllipsisTexture = Font::GetTexture(ci.first, ci.second);
             m_ellipsisWidth = m_ellipsisGlyph.advance_x;
         }
     }
 
-    m_width = 0;                        // computed
-    m_widthIncludingTrailingspaces = 0; // computed
-    m_height = 0;                       // computed
-    m_minHeight = 0;                    // computed
+    ShapeLines(0, uint32_t(m_text.size()), /*isEndOfText:*/ true, m_lines);
+    UpdateTextMetrics();
+}
 
-    FormattedLine* pline = &m_lines.emplace_back();
+void FormattedText::ReplaceText(size_t offset, size_t length, std::string_view text)
+{
+    offset = std::min(offset, m_text.size());
+    length = std::min(length, m_text.size() - offset);
 
-    m_spFont->ForEachCodepoint(m_text, [&](char32_t ch, const CodepointPage& page, const Codepoint& codepoint, float kern)
+    if (!m_isGeometryBuilt || m_atlasEpoch != GlyphAtlas::GetEpoch() || m_fontEpoch != Font::GetEpoch())
     {
-        pline->AddGlyph(Glyph(ch, page.spTexture, codepoint, scale), kern * scale);
+        // nothing worth keeping, the next GetLines builds it all
+        m_text.replace(offset, length, text);
+        m_isGeometryBuilt = false;
+        return;
+    }
 
-        if (is_newline(ch))
-        {
-            FinalizeLineCalculations(*pline);
-            pline = &m_lines.emplace_back();
-        }
-    });
+    if (length == 0 && text.empty())
+        return;
+
+    // lines are broken at '\n' only and kerning starts over after one, so the lines holding
+    // the start and the end of the range are all that change; an edit ending right at the
+    // start of a line still changes that line, it gets prepended to or joined with the one before
+    auto lineAt = [this](size_t pos)
+    {
+        const auto iter = std::upper_bound(m_lines.cbegin(), m_lines.cend(), pos,
+            [](size_t offs, const FormattedLine& line) { return offs < line.textOffset; });
+        return size_t(iter - m_lines.cbegin()) - 1;
+    };
+
+    const size_t firstLine = lineAt(offset);
+    const size_t lastLine = lineAt(offset + length);
+    const uint32_t shapeStart = m_lines[firstLine].textOffset;
+    const uint32_t shapeEnd = m_lines[lastLine].textOffset + m_lines[lastLine].textLength;
+    const int64_t delta = int64_t(text.size()) - int64_t(length);
+
+    m_text.replace(offset, length, text);
+
+    std::vector<FormattedLine> lines;
+    ShapeLines(shapeStart, uint32_t(shapeEnd + delta - shapeStart), /*isEndOfText:*/ lastLine + 1 == m_lines.size(), lines);
+
+    for (size_t i = lastLine + 1; i < m_lines.size(); i++)
+        m_lines[i].textOffset = uint32_t(m_lines[i].textOffset + delta);
+
+    m_lines.erase(m_lines.begin() + firstLine, m_lines.begin() + lastLine + 1);
+    m_lines.insert(m_lines.begin() + firstLine, std::make_move_iterator(lines.begin()), std::make_move_iterator(lines.end()));
 
-    FinalizeLineCalculations(*pline);
+    UpdateTextMetrics();
 }
 
 float FormattedText::AdvanceToNewline(float y) const
@@ -29,19 +29,33 @@ static inline std::string_view to_string(TextAlignment t)
 class FormattedText;
 struct Glyph;
 
+// glyphs of a line that sample the same texture
+struct GlyphRun
+{
+    std::shared_ptr<ITexture> spTexture;
+    uint32_t firstGlyph = 0; // into FormattedLine::glyphs
+    uint32_t glyphCount = 0;
+};
+
 struct FormattedLine
 {
     float lineWidth = 0;
     float lineWidthIncludingTrailingspaces = 0;
     float leftBearingX = 0;
+    float boundsX = 0;           // width including the ellipsis when trimmed
+    uint32_t textOffset = 0;     // byte range of the line in the text, including its '\n'
+    uint32_t textLength = 0;
     bool isOverBudgetX = false;
     bool isOverBudgetY = false;
     std::vector<Glyph> glyphs;
+    std::vector<GlyphRun> runs;
 
     FormattedLine() = default;
     FormattedLine(FormattedLine&&) = default;
     FormattedLine& operator=(FormattedLine&&) = default;
-    void AddGlyph(Glyph&& g, float kern);
+    void AddGlyph(const Glyph& g, const std::shared_ptr<ITexture>& spTexture, float kern);
+    void AppendGlyph(const Glyph& g, const std::shared_ptr<ITexture>& spTexture);
+    void Truncate(size_t glyphCount);
 };
 
 class FormattedText
@@ -49,11 +63,13 @@ class FormattedText
 protected:
     std::string m_text;
     Typeface m_typeface;
+    TypefaceId m_typefaceId = TypefaceId::NotSet; // m_typeface resolved, see Font::GetTypefaceId
     std::shared_ptr<xpf::Font> m_spFont;
     TextTrimming m_textTrimming = TextTrimming(0);
     TextAlignment m_textAlignment = TextAlignment::Left;
     std::vector<FormattedLine> m_lines;
     Glyph m_ellipsisGlyph;
+    std::shared_ptr<ITexture> m_spEllipsisTexture;
 
     float m_lineHeight = 0;                   // acquired from font
     float m_baseline = 0;                     // acquired from font
@@ -65,6 +81,7 @@ protected:
     float m_height = 0;                       // computed
     float m_minHeight = 0;                    // computed
     float m_tabWidth = 0;
+    float m_glyphPadding = 0;                 // empty space around each glyph quad, computed
     v2_t m_bounds;
     v2_t m_boundsNoBearings;
 
@@ -73,6 +90,9 @@ protected:
     uint32_t m_maxLineCount = std::numeric_limits<uint32_t>::max(); // provided by user
 
     bool m_isGeometryBuilt = false;
+    bool m_isDistanceField = false;
+    uint32_t m_atlasEpoch = 0; // glyph atlas layout the texture coordinates were taken from
+    uint32_t m_fontEpoch = 0;  // fonts loaded in the background, see Font::GetEpoch
 
 public:
     FormattedText() = default;
@@ -86,7 +106,14 @@ public:
     bool IsEmpty() const { return m_spFont == nullptr && m_text.empty(); }
 
     void SetText(std::string_view text) { if (m_text != text) { m_isGeometryBuilt = false; m_text = text; } }
-    void SetFont(const Typeface& typeface) { if (typeface != m_typeface) { m_isGeometryBuilt = false; m_typeface = typeface; } }
+
+    // replaces length bytes at offset with text; built geometry is kept and only
+    // the lines the edit touches are shaped again
+    void ReplaceText(size_t offset, size_t length, std::string_view text);
+    void InsertText(size_t offset, std::string_view text) { ReplaceText(offset, 0, text); }
+    void EraseText(size_t offset, size_t length) { ReplaceText(offset, length, {}); }
+    void SetFont(const Typeface& typeface) { if (typeface != m_typeface) { m_isGeometryBuilt = false; m_typeface = typeface; m_typefaceId = TypefaceId::NotSet; } }
+    void SetFont(TypefaceId id) { if (id != m_typefaceId) { m_isGeometryBuilt = false; m_typeface = Font::GetTypeface(id); m_typefaceId = id; } }
     void SetTextTrimming(TextTrimming value) { if (m_textTrimming != value) { m_isGeometryBuilt = false; m_textTrimming = value; } }
     void SetMaxWidth(float value) { if (m_maxWidth != value) { m_isGeometryBuilt = false; m_maxWidth = value; } }
     void SetMaxHeight(float value) { if (m_minHeight != value) { m_isGeometryBuilt = false; m_minHeight = value; } }
@@ -95,6 +122,7 @@ public:
 
     const std::string& GetText() const { return m_text; }
     const Typeface& GetTypeface() const { return m_typeface; }
+    TypefaceId GetTypefaceId() const { return m_typefaceId; }
 
     float GetWidth() const { return m_width; }
     float GetHeight() const { return m_height; }
@@ -109,9 +137,12 @@ public:
     uint32_t GetLineCount() const { return uint32_t(m_lines.size()); }
     float GetLineHeight() const { return m_lineHeight; }
     float GetBaseline() const { return m_baseline; }
+    float GetGlyphPadding() const { return m_glyphPadding; }
+    bool IsDistanceField() const { return m_isDistanceField; }
     float getEllipsisWidth() const { return m_ellipsisWidth; }
 
     void BuildGeometry();
+    bool IsGeometryBuilt() const { return m_isGeometryBuilt; }
     const std::vector<FormattedLine>& GetLines();
     const Glyph& GetEllipsisGlyph();
     float AdvanceToNewline(float y) const;
@@ -120,7 +151,9 @@ public:
     v2_t GetIdealBounds() const { return { GetWidth(), m_lines.size() * GetLineHeight() }; }
 
 protected:
+    void ShapeLines(uint32_t textOffset, uint32_t textLength, bool isEndOfText, std::vector<FormattedLine>& lines);
     void FinalizeLineCalculations(FormattedLine& line);
+    void UpdateTextMetrics();
 };
 
 } // xpf
\ No newline at end of file
@@ -4,10 +4,8 @@
 
 namespace xpf {
 
-Glyph::Glyph(char32_t ch_arg, const std::shared_ptr<ITexture>& spTextureIn, const Codepoint& codepoint, float scale)
-    : spTexture(spTextureIn)
-    , texture_coordinates(codepoint.texCoords)
-    , xoffset(codepoint.xoffset * scale)
+Glyph::Glyph(char32_t ch_arg, const Codepoint& codepoint, float scale)
+    : texture_coordinates(Font::GetTexCoords(codepoint))
     , yoffset(codepoint.yoffset * scale)
     , bearing_x(codepoint.bearingX * scale)
     , width(codepoint.width * scale)
@@ -6,13 +6,13 @@
 namespace xpf {
 
 class ITexture;
-class Codepoint;
+struct Codepoint;
 
+// Packed glyph record of laid out text. The texture it samples is held once per
+// run of glyphs that share it, see FormattedLine::runs.
 struct Glyph
 {
-    std::shared_ptr<ITexture> spTexture;
     rectf_t texture_coordinates;
-    float xoffset = 0;
     float yoffset = 0;
     float bearing_x = 0;
     float width = 0;
@@ -24,7 +24,7 @@ struct Glyph
     Glyph() = default;
     Glyph(Glyph&&) = default;
     Glyph(const Glyph&) = default;
-    Glyph(char32_t ch, const std::shared_ptr<ITexture>& spTextureIn, const Codepoint& codepoint, float scale);
+    Glyph(char32_t ch, const Codepoint& codepoint, float scale);
 
     Glyph& operator=(Glyph&&) = default;
     Glyph& operator=(const Glyph&) = default;
@@ -0,0 +1,287 @@
+#include "GlyphAtlas.h"
+#include <renderer/ITexture.h>
+#include <core/Image.h>
+#include <algorithm>
+#include <cstring>
+
+namespace xpf {
+
+/*static*/ bool GlyphAtlas::Allocate(uint16_t w, uint16_t h, GlyphAtlasSlot& slot, ITexture::Interpolation interpolation)
+{
+    slot = GlyphAtlasSlot();
+    if (w == 0 || h == 0)
+        return false;
+
+    const uint16_t paddedWidth = w + c_padding;
+    const uint16_t paddedHeight = h + c_padding;
+    if (paddedWidth > c_maxSheetSize || paddedHeight > c_maxSheetSize) [[unlikely]]
+        return false;
+
+    auto place = [&](size_t sheetIndex)
+    {
+        Sheet& sheet = s_sheets[sheetIndex];
+        uint16_t x = 0, y = 0;
+        if (!TryPack(sheet, paddedWidth, paddedHeight, x, y))
+            return false;
+
+        slot.sheet = uint16_t(sheetIndex);
+        slot.x = x;
+        slot.y = y;
+        slot.w = w;
+        slot.h = h;
+        slot.generation = sheet.generation;
+        slot.interpolation = interpolation;
+        sheet.lastUsed = ++s_useCounter;
+        return true;
+    };
+
+    for (size_t i = 0; i < s_sheets.size(); i++)
+    {
+        if (place(i)) [[likely]]
+            return true;
+    }
+
+    // prefer a bigger sheet over another texture, fewer textures means fewer batch breaks
+    for (size_t i = 0; i < s_sheets.size(); i++)
+    {
+        while (s_sheets[i].size < c_maxSheetSize)
+        {
+            Grow(s_sheets[i]);
+            if (place(i))
+                return true;
+        }
+    }
+
+    size_t sheetIndex = 0;
+    if (s_sheets.size() < c_maxSheetCount)
+    {
+        sheetIndex = s_sheets.size();
+        Sheet& sheet = s_sheets.emplace_back();
+        sheet.size = c_initialSheetSize;
+        sheet.pixels.resize(sheet.size * sheet.size);
+        Clear(sheet);
+    }
+    else
+    {
+        // every sheet is full, start over in the least recently used one
+        const auto iter = std::min_element(
+            s_sheets.cbegin(), s_sheets.cend(),
+            [](const Sheet& a, const Sheet& b) { return a.lastUsed < b.lastUsed; });
+        sheetIndex = size_t(iter - s_sheets.cbegin());
+        Clear(s_sheets[sheetIndex]);
+    }
+
+    for (;;)
+    {
+        if (place(sheetIndex))
+            return true;
+        if (s_sheets[sheetIndex].size >= c_maxSheetSize)
+            return false;
+        Grow(s_sheets[sheetIndex]);
+    }
+}
+
+/*static*/ void GlyphAtlas::Write(const GlyphAtlasSlot& slot, const byte_t* pdata, uint32_t rowLength)
+{
+    if (!IsValid(slot) || pdata == nullptr)
+        return;
+
+    Sheet& sheet = s_sheets[slot.sheet];
+    byte_t* pdest = sheet.pixels.data() + slot.y * sheet.size + slot.x;
+    for (uint32_t row = 0; row < slot.h; row++)
+        std::memcpy(pdest + row * sheet.size, pdata + row * rowLength, slot.w);
+
+    const recti_t region{slot.x, slot.y, slot.w, slot.h};
+    if (!sheet.isDirty)
+    {
+        sheet.dirty = region;
+        sheet.isDirty = true;
+    }
+    else
+    {
+        const int32_t left = std::min(sheet.dirty.x, region.x);
+        const int32_t top = std::min(sheet.dirty.y, region.y);
+        const int32_t right = std::max(sheet.dirty.x + sheet.dirty.w, region.x + region.w);
+        const int32_t bottom = std::max(sheet.dirty.y + sheet.dirty.h, region.y + region.h);
+        sheet.dirty = recti_t::from_points(left, top, right, bottom);
+    }
+}
+
+/*static*/ bool GlyphAtlas::Read(const GlyphAtlasSlot& slot, std::vector<byte_t>& pixels)
+{
+    if (!IsValid(slot))
+        return false;
+
+    const Sheet& sheet = s_sheets[slot.sheet];
+    const byte_t* psource = sheet.pixels.data() + slot.y * sheet.size + slot.x;
+    pixels.resize(slot.w * slot.h);
+    for (uint32_t row = 0; row < slot.h; row++)
+        std::memcpy(pixels.data() + row * slot.w, psource + row * sheet.size, slot.w);
+
+    return true;
+}
+
+/*static*/ const std::shared_ptr<ITexture>& GlyphAtlas::GetTexture(const GlyphAtlasSlot& slot)
+{
+    static const std::shared_ptr<ITexture> s_noTexture;
+    if (slot.sheet >= s_sheets.size()) [[unlikely]]
+        return s_noTexture;
+
+    Sheet& sheet = s_sheets[slot.sheet];
+    if (sheet.spTexture == nullptr) [[unlikely]]
+        Commit(sheet);
+
+    if (slot.interpolation == ITexture::Interpolation::None || sheet.spTexture == nullptr)
+        return sheet.spTexture;
+
+    if (sheet.spLinearTexture == nullptr)
+        sheet.spLinearTexture = sheet.spTexture->SampledTexture(ITexture::Interpolation::Linear);
+
+    return sheet.spLinearTexture;
+}
+
+/*static*/ void GlyphAtlas::CommitPending()
+{
+    for (Sheet& sheet : s_sheets)
+    {
+        if (sheet.isDirty)
+            Commit(sheet);
+    }
+}
+
+/*static*/ bool GlyphAtlas::TryPack(Sheet& sheet, uint16_t w, uint16_t h, uint16_t& xOut, uint16_t& yOut)
+{
+    // bottom-left skyline: place at the lowest spot, ties go to the narrowest segment
+    auto& skyline = sheet.skyline;
+    size_t bestIndex = skyline.size();
+    uint32_t bestY = UINT32_MAX;
+    uint32_t bestWidth = UINT32_MAX;
+
+    for (size_t i = 0; i < skyline.size(); i++)
+    {
+        const uint32_t x = skyline[i].x;
+        if (x + w > sheet.size)
+            break; // nodes are sorted by x, nothing further right can fit either
+
+        uint32_t y = 0;
+        uint32_t widthLeft = w;
+        for (size_t j = i; widthLeft > 0 && j < skyline.size(); j++)
+        {
+            y = std::max<uint32_t>(y, skyline[j].y);
+            widthLeft -= std::min<uint32_t>(widthLeft, skyline[j].w);
+        }
+
+        if (y + h > sheet.size)
+            continue;
+
+        if (y < bestY || (y == bestY && skyline[i].w < bestWidth))
+        {
+            bestIndex = i;
+            bestY = y;
+            bestWidth = skyline[i].w;
+        }
+    }
+
+    if (bestIndex == skyline.size())
+        return false;
+
+    xOut = skyline[bestIndex].x;
+    yOut = uint16_t(bestY);
+    skyline.insert(skyline.begin() + bestIndex, SkylineNode{xOut, uint16_t(bestY + h), w});
+
+    // trim the segments now covered by the new one
+    for (size_t i = bestIndex + 1; i < skyline.size();)
+    {
+        const SkylineNode& prev = skyline[i - 1];
+        SkylineNode& node = skyline[i];
+        const uint32_t prevRight = prev.x + prev.w;
+        if (node.x >= prevRight)
+            break;
+
+        const uint32_t shrink = prevRight - node.x;
+        if (node.w <= shrink)
+        {
+            skyline.erase(skyline.begin() + i);
+            continue;
+        }
+
+        node.x += shrink;
+        node.w -= shrink;
+        break;
+    }
+
+    for (size_t i = 0; i + 1 < skyline.size();)
+    {
+        if (skyline[i].y == skyline[i + 1].y)
+        {
+            skyline[i].w += skyline[i + 1].w;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return true;
+}
+
+/*static*/ void GlyphAtlas::Grow(Sheet& sheet)
+{
+    // batches built earlier this frame keep drawing from the old texture, give it the pending glyphs
+    if (sheet.isDirty && sheet.spTexture != nullptr)
+        Commit(sheet);
+
+    const uint32_t oldSize = sheet.size;
+    const uint32_t newSize = std::min(oldSize * 2, c_maxSheetSize);
+
+    std::vector<byte_t> pixels(newSize * newSize);
+    for (uint32_t row = 0; row < oldSize; row++)
+        std::memcpy(pixels.data() + row * newSize, sheet.pixels.data() + row * oldSize, oldSize);
+
+    sheet.pixels = std::move(pixels);
+    sheet.size = newSize;
+    sheet.skyline.push_back({uint16_t(oldSize), 0, uint16_t(newSize - oldSize)});
+
+    // slots keep their pixels, only normalized texture coordinates change
+    sheet.spTexture = nullptr;
+    sheet.spLinearTexture = nullptr;
+    sheet.isDirty = false;
+    s_epoch++;
+}
+
+/*static*/ void GlyphAtlas::Clear(Sheet& sheet)
+{
+    if (sheet.isDirty && sheet.spTexture != nullptr)
+        Commit(sheet);
+
+    std::fill(sheet.pixels.begin(), sheet.pixels.end(), 0);
+    sheet.skyline.clear();
+    sheet.skyline.push_back({0, 0, uint16_t(sheet.size)});
+    sheet.generation++;
+    sheet.spTexture = nullptr;
+    sheet.spLinearTexture = nullptr;
+    sheet.isDirty = false;
+    s_epoch++;
+}
+
+/*static*/ void GlyphAtlas::Commit(Sheet& sheet)
+{
+    if (sheet.spTexture == nullptr)
+    {
+        if (ITexture::TextureLoader == nullptr) [[unlikely]]
+            return;
+
+        std::vector<byte_t> pixels = sheet.pixels;
+        sheet.spTexture = ITexture::TextureLoader(std::move(pixels), sheet.size, sheet.size, PixelFormat::GrayScale, /*mipMapCount*/ 1);
+    }
+    else
+    {
+        const recti_t& region = sheet.dirty;
+        sheet.spTexture->UpdatePixels(region, sheet.pixels.data() + region.y * sheet.size + region.x, sheet.size);
+    }
+
+    sheet.isDirty = false;
+}
+
+} // xpf
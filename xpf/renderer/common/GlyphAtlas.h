@@ -0,0 +1,114 @@
+#pragma once
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <core/Rectangle.h>
+#include <core/Types.h>
+#include <renderer/ITexture.h>
+
+namespace xpf {
+
+struct GlyphAtlasSlot
+{
+    static constexpr uint16_t c_noSheet = UINT16_MAX;
+
+    uint16_t sheet = c_noSheet;
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint16_t w = 0;
+    uint16_t h = 0;
+    uint32_t generation = 0;
+    ITexture::Interpolation interpolation = ITexture::Interpolation::None; // how the glyph's pixels are sampled
+
+    bool IsAllocated() const { return sheet != c_noSheet; }
+};
+
+// Texture rendered glyphs of every font and size share a handful of GrayScale sheets.
+// Each sheet is skyline packed, grows by doubling until c_maxSheetSize and is uploaded
+// incrementally (dirty region only). When all sheets are full the least recently used
+// one is cleared; slots pointing into it become invalid and have to be rasterized again.
+//
+// Growing or clearing a sheet swaps in a new texture, batches that were already built keep
+// drawing from the old one (pending glyphs are uploaded to it first). GetEpoch() changes whenever this happens so that cached
+// texture coordinates (i.e. FormattedText glyphs) can be rebuilt.
+class GlyphAtlas
+{
+protected:
+    struct SkylineNode
+    {
+        uint16_t x = 0;
+        uint16_t y = 0;
+        uint16_t w = 0;
+    };
+
+    struct Sheet
+    {
+        std::shared_ptr<ITexture> spTexture;
+        std::shared_ptr<ITexture> spLinearTexture; // same texture, sampled with linear filtering
+        std::vector<byte_t> pixels;
+        std::vector<SkylineNode> skyline;
+        uint32_t size = 0;
+        uint32_t generation = 1;
+        uint64_t lastUsed = 0;
+        recti_t dirty;
+        bool isDirty = false;
+    };
+
+    static constexpr uint32_t c_initialSheetSize = 256;
+    static constexpr uint32_t c_maxSheetSize = 2048;
+    static constexpr uint32_t c_maxSheetCount = 4;
+    static constexpr uint16_t c_padding = 1;
+
+    static inline std::vector<Sheet> s_sheets;
+    static inline uint64_t s_useCounter = 0;
+    static inline uint32_t s_epoch = 0;
+
+public:
+    GlyphAtlas() = delete;
+
+    // reserves a w x h region, growing or evicting sheets as needed; false if the glyph can never fit
+    static bool Allocate(
+        uint16_t w, uint16_t h,
+        GlyphAtlasSlot& slot,
+        ITexture::Interpolation interpolation = ITexture::Interpolation::None);
+
+    // copies w*h GrayScale pixels (rowLength apart) into the slot and marks them for upload
+    static void Write(const GlyphAtlasSlot& slot, const byte_t* pdata, uint32_t rowLength);
+
+    // copies the slot's w*h pixels out, false if the slot is no longer valid
+    static bool Read(const GlyphAtlasSlot& slot, std::vector<byte_t>& pixels);
+
+    static bool IsValid(const GlyphAtlasSlot& slot)
+    {
+        return slot.sheet < s_sheets.size() && s_sheets[slot.sheet].generation == slot.generation;
+    }
+
+    static void Touch(const GlyphAtlasSlot& slot)
+    {
+        if (slot.sheet < s_sheets.size())
+            s_sheets[slot.sheet].lastUsed = ++s_useCounter;
+    }
+
+    static rectf_t GetTexCoords(const GlyphAtlasSlot& slot)
+    {
+        const float scale = 1.0f / float(s_sheets[slot.sheet].size);
+        return rectf_t{float(slot.x), float(slot.y), float(slot.w), float(slot.h)}.multiply(scale, scale);
+    }
+
+    // texture of the slot's sheet, glyphs written since the last CommitPending are not uploaded yet
+    static const std::shared_ptr<ITexture>& GetTexture(const GlyphAtlasSlot& slot);
+
+    // uploads the dirty region of every sheet, renderers call this once per frame before drawing
+    static void CommitPending();
+
+    static uint32_t GetEpoch() { return s_epoch; }
+    static uint32_t GetSheetCount() { return uint32_t(s_sheets.size()); }
+
+protected:
+    static bool TryPack(Sheet& sheet, uint16_t w, uint16_t h, uint16_t& x, uint16_t& y);
+    static void Grow(Sheet& sheet);
+    static void Clear(Sheet& sheet);
+    static void Commit(Sheet& sheet);
+};
+
+} // xpf
@@ -0,0 +1,334 @@
+#include "GlyphCache.h"
+#include <renderer/common/Font.h>
+#include <core/FileSystem.h>
+#include <core/Hash.h>
+#include <core/Log.h>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+namespace xpf {
+
+// file layout, native byte order since the cache never leaves the machine:
+//   "XPGC" version contentHash keyLength key
+//   pageCount  { pageIndex count { index glyphindex xoffset yoffset bearingX width height advance texCoords } }
+//   glyphCount { glyphIndex width height xoffset yoffset outlineCount pixelCount outline pixels }
+static constexpr char c_magic[4] = {'X', 'P', 'G', 'C'};
+static constexpr uint32_t c_codepointRecordSize = 12 * sizeof(uint32_t);
+static constexpr uint32_t c_glyphRecordSize = 7 * sizeof(uint32_t);
+
+template <typename T>
+static void Append(std::vector<byte_t>& data, T value)
+{
+    const size_t offset = data.size();
+    data.resize(offset + sizeof(T));
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+static void Append(std::vector<byte_t>& data, const void* pdata, size_t size)
+{
+    const byte_t* pbytes = static_cast<const byte_t*>(pdata);
+    data.insert(data.end(), pbytes, pbytes + size);
+}
+
+template <typename T>
+static T Read(const byte_t* pdata)
+{
+    T value;
+    std::memcpy(&value, pdata, sizeof(T));
+    return value;
+}
+
+/*static*/ uint64_t GlyphCache::HashContent(const byte_t* pdata, size_t size)
+{
+    // a word at a time, fonts are megabytes
+    hash64 hash;
+    hash.Append(uint64_t(size));
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        hash.Append(Read<uint64_t>(pdata + i));
+    for (; i < size; i++)
+        hash.Append(uint64_t(pdata[i]));
+
+    // zero means "not hashed"
+    const uint64_t result = hash.Finalize();
+    return result != 0 ? result : 1;
+}
+
+static std::string GetEnvironment(const char* pname)
+{
+    const char* pvalue = std::getenv(pname);
+    return pvalue != nullptr ? pvalue : "";
+}
+
+/*static*/ std::string GlyphCache::GetDefaultDirectory()
+{
+#if defined(PLATFORM_WINDOWS)
+    const std::string localAppData = GetEnvironment("LOCALAPPDATA");
+    return localAppData.empty() ? "" : localAppData + "\\xpf\\glyphcache";
+#elif defined(PLATFORM_APPLE)
+    const std::string home = GetEnvironment("HOME");
+    return home.empty() ? "" : home + "/Library/Caches/xpf/glyphcache";
+#else
+    const std::string cacheHome = GetEnvironment("XDG_CACHE_HOME");
+    if (!cacheHome.empty())
+        return cacheHome + "/xpf/glyphcache";
+
+    const std::string home = GetEnvironment("HOME");
+    return home.empty() ? "" : home + "/.cache/xpf/glyphcache";
+#endif
+}
+
+std::string GlyphCache::GetFilename() const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.glyphcache", static_cast<unsigned long long>(hash64().Append(m_key.cbegin(), m_key.cend()).Finalize()));
+    return s_directory + "/" + name;
+}
+
+/*static*/ std::shared_ptr<GlyphCache> GlyphCache::Open(std::string_view key, uint64_t contentHash)
+{
+    auto spCache = std::make_shared<GlyphCache>(key, contentHash);
+    spCache->Load();
+    return spCache;
+}
+
+void GlyphCache::Load()
+{
+    // a save that could not replace the file while it was mapped left the new one beside it
+    const std::string filename = GetFilename();
+    std::error_code error;
+    if (std::filesystem::exists(filename + ".new", error))
+        std::filesystem::rename(filename + ".new", filename, error);
+
+    m_spFile = FileSystem::MapFile(filename);
+    if (m_spFile != nullptr && !Parse())
+        Close(); // stale or damaged, the next save replaces it
+}
+
+void GlyphCache::Close()
+{
+    m_spFile.reset();
+    m_pages.clear();
+    m_glyphs.clear();
+}
+
+bool GlyphCache::Parse()
+{
+    const byte_t* pdata = m_spFile->data();
+    const size_t size = m_spFile->size();
+    size_t offset = 0;
+    auto has = [&](size_t bytes) { return offset + bytes <= size; };
+
+    if (!has(sizeof(c_magic) + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t)))
+        return false;
+    if (std::memcmp(pdata, c_magic, sizeof(c_magic)) != 0)
+        return false;
+    offset += sizeof(c_magic);
+    if (Read<uint32_t>(pdata + offset) != c_version)
+        return false;
+    offset += sizeof(uint32_t);
+    if (Read<uint64_t>(pdata + offset) != m_contentHash)
+        return false;
+    offset += sizeof(uint64_t);
+
+    const uint32_t keyLength = Read<uint32_t>(pdata + offset);
+    offset += sizeof(uint32_t);
+    if (!has(keyLength) || std::string_view(reinterpret_cast<const char*>(pdata + offset), keyLength) != m_key)
+        return false;
+    offset += keyLength;
+
+    if (!has(sizeof(uint32_t)))
+        return false;
+    const uint32_t pageCount = Read<uint32_t>(pdata + offset);
+    offset += sizeof(uint32_t);
+    for (uint32_t i = 0; i < pageCount; i++)
+    {
+        if (!has(2 * sizeof(uint32_t)))
+            return false;
+        const uint32_t pageIndex = Read<uint32_t>(pdata + offset);
+        const uint32_t count = Read<uint32_t>(pdata + offset + sizeof(uint32_t));
+        m_pages[pageIndex] = uint32_t(offset);
+        offset += 2 * sizeof(uint32_t);
+        if (!has(size_t(count) * c_codepointRecordSize))
+            return false;
+        offset += size_t(count) * c_codepointRecordSize;
+    }
+
+    if (!has(sizeof(uint32_t)))
+        return false;
+    const uint32_t glyphCount = Read<uint32_t>(pdata + offset);
+    offset += sizeof(uint32_t);
+    for (uint32_t i = 0; i < glyphCount; i++)
+    {
+        if (!has(c_glyphRecordSize))
+            return false;
+
+        const byte_t* precord = pdata + offset;
+        const int32_t glyphIndex = Read<int32_t>(precord);
+        Glyph glyph;
+        glyph.width = Read<int32_t>(precord + 4);
+        glyph.height = Read<int32_t>(precord + 8);
+        glyph.xoffset = Read<int32_t>(precord + 12);
+        glyph.yoffset = Read<int32_t>(precord + 16);
+        glyph.outlineCount = Read<uint32_t>(precord + 20);
+        glyph.pixelCount = Read<uint32_t>(precord + 24);
+        offset += c_glyphRecordSize;
+
+        glyph.outlineOffset = uint32_t(offset);
+        glyph.pixelOffset = uint32_t(offset + size_t(glyph.outlineCount) * sizeof(int16_t));
+        const size_t dataSize = size_t(glyph.outlineCount) * sizeof(int16_t) + glyph.pixelCount;
+        if (!has(dataSize))
+            return false;
+        offset += dataSize;
+
+        m_glyphs[glyphIndex] = glyph;
+    }
+
+    return true;
+}
+
+bool GlyphCache::RestorePage(uint32_t pageIndex, CodepointPage& page) const
+{
+    const auto iter = m_pages.find(pageIndex);
+    if (iter == m_pages.cend())
+        return false;
+
+    const byte_t* precord = m_spFile->data() + iter->second;
+    const uint32_t count = Read<uint32_t>(precord + sizeof(uint32_t));
+    precord += 2 * sizeof(uint32_t);
+    for (uint32_t i = 0; i < count; i++, precord += c_codepointRecordSize)
+    {
+        const uint32_t index = Read<uint32_t>(precord);
+        if (index >= page.codepoints.size())
+            continue;
+
+        Codepoint codepoint;
+        codepoint.glyphindex = Read<int32_t>(precord + 4);
+        codepoint.xoffset = Read<float>(precord + 8);
+        codepoint.yoffset = Read<float>(precord + 12);
+        codepoint.bearingX = Read<float>(precord + 16);
+        codepoint.width = Read<float>(precord + 20);
+        codepoint.height = Read<float>(precord + 24);
+        codepoint.advance = Read<float>(precord + 28);
+        codepoint.texCoords = rectf_t{Read<float>(precord + 32), Read<float>(precord + 36), Read<float>(precord + 40), Read<float>(precord + 44)};
+        codepoint.needsRasterization = true;
+        page.Set(index, std::move(codepoint));
+    }
+
+    return true;
+}
+
+void GlyphCache::AppendOutline(const Glyph& glyph, std::vector<int16_t>& outline) const
+{
+    const size_t offset = outline.size();
+    outline.resize(offset + glyph.outlineCount);
+    std::memcpy(outline.data() + offset, m_spFile->data() + glyph.outlineOffset, glyph.outlineCount * sizeof(int16_t));
+}
+
+void GlyphCache::Writer::AddPage(uint32_t pageIndex, const CodepointPage& page)
+{
+    if (!m_writtenPages.insert(pageIndex).second)
+        return;
+
+    const size_t countOffset = m_pages.size() + sizeof(uint32_t);
+    Append(m_pages, pageIndex);
+    Append(m_pages, uint32_t(0));
+
+    uint32_t count = 0;
+    for (uint32_t index = 0; index < page.codepoints.size(); index++)
+    {
+        const Codepoint* pcodepoint = page.Find(index);
+        if (pcodepoint == nullptr)
+            continue;
+
+        Append(m_pages, index);
+        Append(m_pages, int32_t(pcodepoint->glyphindex));
+        Append(m_pages, pcodepoint->xoffset);
+        Append(m_pages, pcodepoint->yoffset);
+        Append(m_pages, pcodepoint->bearingX);
+        Append(m_pages, pcodepoint->width);
+        Append(m_pages, pcodepoint->height);
+        Append(m_pages, pcodepoint->advance);
+        Append(m_pages, pcodepoint->texCoords.x);
+        Append(m_pages, pcodepoint->texCoords.y);
+        Append(m_pages, pcodepoint->texCoords.w);
+        Append(m_pages, pcodepoint->texCoords.h);
+        count++;
+    }
+
+    std::memcpy(m_pages.data() + countOffset, &count, sizeof(count));
+    m_pageCount++;
+}
+
+void GlyphCache::Writer::AddGlyph(int32_t glyphIndex, const Glyph& glyph, const int16_t* poutline, const byte_t* ppixels)
+{
+    if (!m_writtenGlyphs.insert(glyphIndex).second)
+        return;
+
+    Append(m_glyphs, glyphIndex);
+    Append(m_glyphs, glyph.width);
+    Append(m_glyphs, glyph.height);
+    Append(m_glyphs, glyph.xoffset);
+    Append(m_glyphs, glyph.yoffset);
+    Append(m_glyphs, glyph.outlineCount);
+    Append(m_glyphs, glyph.pixelCount);
+    Append(m_glyphs, poutline, glyph.outlineCount * sizeof(int16_t));
+    Append(m_glyphs, ppixels, glyph.pixelCount);
+    m_glyphCount++;
+}
+
+bool GlyphCache::Writer::Save(const GlyphCache& cache)
+{
+    if (s_directory.empty())
+        return false;
+
+    // keep what earlier runs built and this one did not need
+    for (const auto& [pageIndex, offset] : cache.m_pages)
+    {
+        if (!m_writtenPages.insert(pageIndex).second)
+            continue;
+
+        const uint32_t count = Read<uint32_t>(cache.m_spFile->data() + offset + sizeof(uint32_t));
+        Append(m_pages, cache.m_spFile->data() + offset, 2 * sizeof(uint32_t) + size_t(count) * c_codepointRecordSize);
+        m_pageCount++;
+    }
+
+    for (const auto& [glyphIndex, glyph] : cache.m_glyphs)
+    {
+        AddGlyph(
+            glyphIndex, glyph,
+            reinterpret_cast<const int16_t*>(cache.m_spFile->data() + glyph.outlineOffset),
+            cache.m_spFile->data() + glyph.pixelOffset);
+    }
+
+    std::vector<byte_t> data;
+    data.reserve(64 + cache.m_key.size() + m_pages.size() + m_glyphs.size());
+    Append(data, c_magic, sizeof(c_magic));
+    Append(data, c_version);
+    Append(data, cache.m_contentHash);
+    Append(data, uint32_t(cache.m_key.size()));
+    Append(data, cache.m_key.data(), cache.m_key.size());
+    Append(data, m_pageCount);
+    Append(data, m_pages.data(), m_pages.size());
+    Append(data, m_glyphCount);
+    Append(data, m_glyphs.data(), m_glyphs.size());
+
+    // the cache stays mapped and untouched, font workers may still be reading it. The new file
+    // goes next to it and is renamed over it; where a mapped file cannot be replaced the rename
+    // fails and the next Load picks the new file up instead
+    std::error_code error;
+    std::filesystem::create_directories(s_directory, error);
+
+    const std::string filename = cache.GetFilename();
+    if (!FileSystem::SaveFile(filename + ".new", data.data(), data.size()))
+    {
+        Log::error("GlyphCache: failed to write " + filename + ".new");
+        return false;
+    }
+
+    std::filesystem::rename(filename + ".new", filename, error);
+    return true;
+}
+
+} // xpf
@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <core/MappedFile.h>
+#include <core/Types.h>
+
+namespace xpf {
+
+struct Codepoint;
+struct CodepointPage;
+
+// Glyph data a font built in an earlier run, read back from one file per font:
+// codepoint metrics of the pages that were loaded, outline/triangle buffers of shader
+// rendered glyphs and bitmaps of texture rendered glyphs. The file carries a hash of the
+// font file it was built from and a format version; a mismatch makes it start out empty,
+// and the next save replaces it.
+class GlyphCache
+{
+public:
+    static constexpr uint32_t c_version = 1;
+
+    // per-user cache directory of the platform, empty when the environment does not name one
+    static std::string GetDefaultDirectory();
+
+    struct Glyph
+    {
+        int32_t width = 0;
+        int32_t height = 0;
+        int32_t xoffset = 0;
+        int32_t yoffset = 0;
+        uint32_t outlineOffset = 0; // byte offsets into the cache file
+        uint32_t outlineCount = 0;  // in number of 'short's
+        uint32_t pixelOffset = 0;
+        uint32_t pixelCount = 0;
+    };
+
+    // accumulates what a font built this run, carrying over what it did not touch from the old file
+    class Writer
+    {
+    protected:
+        std::vector<byte_t> m_pages;
+        std::vector<byte_t> m_glyphs;
+        uint32_t m_pageCount = 0;
+        uint32_t m_glyphCount = 0;
+        std::unordered_set<uint32_t> m_writtenPages;
+        std::unordered_set<int32_t> m_writtenGlyphs;
+
+    public:
+        void AddPage(uint32_t pageIndex, const CodepointPage& page);
+        void AddGlyph(int32_t glyphIndex, const Glyph& glyph, const int16_t* poutline, const byte_t* ppixels);
+        bool Save(const GlyphCache& cache);
+    };
+
+protected:
+    static inline std::string s_directory = GetDefaultDirectory(); // empty: caching is off
+
+    std::string m_key;
+    uint64_t m_contentHash = 0;
+    std::shared_ptr<const MappedFile> m_spFile; // null when there was no valid file
+    std::unordered_map<uint32_t, uint32_t> m_pages;  // page index -> byte offset of its codepoints
+    std::unordered_map<int32_t, Glyph> m_glyphs;     // glyph index -> record
+
+public:
+    GlyphCache(std::string_view key, uint64_t contentHash) : m_key(key), m_contentHash(contentHash) {}
+
+    static void SetDirectory(std::string_view directory) { s_directory = directory; }
+    static bool IsEnabled() { return !s_directory.empty(); }
+
+    // hash of a font file's content, what a cache file is validated against
+    static uint64_t HashContent(const byte_t* pdata, size_t size);
+
+    // cache of the font with the given key, empty when there is no valid file yet
+    static std::shared_ptr<GlyphCache> Open(std::string_view key, uint64_t contentHash);
+
+    // fills page with the cached codepoint metrics, glyphs are still to be built; false if not cached
+    bool RestorePage(uint32_t pageIndex, CodepointPage& page) const;
+
+    const Glyph* FindGlyph(int32_t glyphIndex) const
+    {
+        const auto iter = m_glyphs.find(glyphIndex);
+        return iter != m_glyphs.cend() ? &iter->second : nullptr;
+    }
+
+    void AppendOutline(const Glyph& glyph, std::vector<int16_t>& outline) const;
+    const byte_t* GetPixels(const Glyph& glyph) const { return m_spFile->data() + glyph.pixelOffset; }
+
+protected:
+    std::string GetFilename() const;
+    void Load();
+    void Close();
+    bool Parse();
+};
+
+} // xpf
@@ -0,0 +1,61 @@
+#include "KerningTable.h"
+#include <stb/stb_truetype.h>
+
+namespace xpf {
+
+static uint16_t ReadUShort(const uint8_t* p) { return uint16_t(p[0] << 8 | p[1]); }
+static int16_t ReadShort(const uint8_t* p) { return int16_t(p[0] << 8 | p[1]); }
+
+void KerningTable::Build(const stbtt_fontinfo& info)
+{
+    m_entries.clear();
+    m_hasKerning.clear();
+    m_mask = 0;
+
+    // same subset of the 'kern' table stbtt__GetGlyphKernInfoAdvance understands:
+    // the first subtable, horizontal format 0, pairs sorted by (left, right)
+    if (info.kern == 0)
+        return;
+
+    const uint8_t* pdata = info.data + info.kern;
+    if (ReadUShort(pdata + 2) < 1) // number of tables
+        return;
+    if (ReadUShort(pdata + 8) != 1) // horizontal flag, format 0
+        return;
+
+    const uint32_t pairCount = ReadUShort(pdata + 10);
+    if (pairCount == 0)
+        return;
+
+    uint32_t capacity = 16;
+    while (capacity < pairCount * 2)
+        capacity *= 2;
+
+    m_entries.resize(capacity);
+    m_mask = capacity - 1;
+    m_hasKerning.resize((uint32_t(info.numGlyphs) + 63) / 64);
+
+    const uint8_t* ppair = pdata + 18;
+    for (uint32_t i = 0; i < pairCount; i++, ppair += 6)
+    {
+        const int32_t advance = ReadShort(ppair + 4);
+        if (advance != 0)
+            Insert(ReadUShort(ppair), ReadUShort(ppair + 2), advance);
+    }
+}
+
+void KerningTable::Insert(uint32_t leftGlyph, uint32_t rightGlyph, int32_t advance)
+{
+    if (leftGlyph / 64 >= m_hasKerning.size())
+        m_hasKerning.resize(leftGlyph / 64 + 1);
+    m_hasKerning[leftGlyph / 64] |= uint64_t(1) << (leftGlyph % 64);
+
+    const uint32_t key = (leftGlyph << 16) | rightGlyph;
+    uint32_t slot = Hash(key) & m_mask;
+    while (m_entries[slot].key != c_emptyKey && m_entries[slot].key != key)
+        slot = (slot + 1) & m_mask;
+
+    m_entries[slot] = {key, advance};
+}
+
+} // xpf
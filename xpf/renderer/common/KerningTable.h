@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+struct stbtt_fontinfo;
+
+namespace xpf {
+
+// Kerning pairs of a font's 'kern' table, read once into an open addressing hash table.
+// A bit per glyph tells whether the glyph starts any pair at all, so the common
+// no-kerning case is a single bit test.
+class KerningTable
+{
+protected:
+    static constexpr uint32_t c_emptyKey = UINT32_MAX;
+
+    struct Entry
+    {
+        uint32_t key = c_emptyKey; // (left glyph << 16) | right glyph
+        int32_t advance = 0;
+    };
+
+    std::vector<Entry> m_entries; // size is a power of two
+    std::vector<uint64_t> m_hasKerning;
+    uint32_t m_mask = 0;
+
+public:
+    void Build(const stbtt_fontinfo& info);
+
+    bool IsEmpty() const { return m_entries.empty(); }
+
+    int32_t Get(uint32_t leftGlyph, uint32_t rightGlyph) const
+    {
+        if (leftGlyph / 64 >= m_hasKerning.size() || !(m_hasKerning[leftGlyph / 64] & (uint64_t(1) << (leftGlyph % 64)))) [[likely]]
+            return 0;
+
+        const uint32_t key = (leftGlyph << 16) | (rightGlyph & 0xffff);
+        for (uint32_t slot = Hash(key) & m_mask;; slot = (slot + 1) & m_mask)
+        {
+            const Entry& entry = m_entries[slot];
+            if (entry.key == key)
+                return entry.advance;
+            if (entry.key == c_emptyKey)
+                return 0;
+        }
+    }
+
+protected:
+    static uint32_t Hash(uint32_t key) { return (key * 0x9e3779b1u) >> 7; }
+    void Insert(uint32_t leftGlyph, uint32_t rightGlyph, int32_t advance);
+};
+
+} // xpf
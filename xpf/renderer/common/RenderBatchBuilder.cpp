@@ -2,6 +2,7 @@
 #include "FormattedText.h"
 #include <core/Quad.h>
 #include <math/geometry.h>
+#include <algorithm>
 
 namespace xpf {
 
@@ -18,6 +19,17 @@ RenderBatch RenderBatchBuilder::Build()
 
 void RenderBatchBuilder::Flush()
 {
+    // instances are only ever ahead of pending vertices, PushTextInstance flushes vertices first
+    if (!m_textInstances.empty())
+    {
+        m_commands.push_back(std::make_shared<RenderTextInstancesCommand>(
+            m_textInstancesCommandId, std::move(m_textInstances), m_spTextInstancesTexture
+        ));
+
+        m_textInstances.clear();
+        m_spTextInstancesTexture = nullptr;
+    }
+
     if (!m_vertices.empty())
     {
         m_commands.push_back(std::make_shared<RenderDrawCommand>(
@@ -115,6 +127,35 @@ StackGuard RenderBatchBuilder::Clip(rectui_t clipRegion)
     });
 }
 
+bool RenderBatchBuilder::UsesInstancedText() const
+{
+    return m_pRenderer != nullptr && (m_pRenderer->GetCapabilities() & RendererCapability::InstancedTexturedText);
+}
+
+void RenderBatchBuilder::PushTextInstance(const std::shared_ptr<ITexture>& spTexture, RenderCommandId commandId, const rectf_t& position, const rectf_t& texCoords, v4_t tint)
+{
+    // one instanced draw per texture, it only breaks when something else was drawn in between
+    if (!m_vertices.empty() ||
+        (!m_textInstances.empty() && (m_spTextInstancesTexture != spTexture || m_textInstancesCommandId != commandId)))
+        Flush();
+
+    if (m_textInstances.empty())
+    {
+        m_spTextInstancesTexture = spTexture;
+        m_textInstancesCommandId = commandId;
+    }
+
+    auto unorm16 = [](float v) { return uint16_t(std::clamp(v, 0.0f, 1.0f) * 65535.0f + 0.5f); };
+    auto unorm8 = [](float v) { return uint8_t(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    auto size16 = [](float v) { return uint16_t(std::clamp(v * RenderTextInstancesCommand::c_sizeScale + 0.5f, 0.0f, 65535.0f)); };
+
+    m_textInstances.push_back({
+        position.x, position.y,
+        size16(position.w), size16(position.h),
+        unorm16(texCoords.x), unorm16(texCoords.y), unorm16(texCoords.x + texCoords.w), unorm16(texCoords.y + texCoords.h),
+        unorm8(tint.x), unorm8(tint.y), unorm8(tint.z), unorm8(tint.w)});
+}
+
 void RenderBatchBuilder::Push(v2_t pos, const xpf::Color color) {
     v4_t c = color.get_vec4();
     m_vertices.push_back(pos.x);
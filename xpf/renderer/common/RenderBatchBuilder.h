@@ -100,6 +100,9 @@ struct TextDescription
     uint16_t fontIndex = 0;
     TextTrimming trimming = TextTrimming::None;
     FontRenderOptions renderOptions = FontRenderOptions::Texture;
+    // resolved from the fields above on first draw and again once they no longer match,
+    // keep the description around (e.g. as a member) for the id to be reused
+    mutable TypefaceId typefaceId = TypefaceId::NotSet;
 };
 
 struct PolyLineVertex
@@ -121,6 +124,9 @@ protected:
     IRenderer* m_pRenderer;
     std::vector<float> m_vertices;
     std::vector<GlyphInstanceData> m_glyphInstanceData;
+    std::vector<RenderTextInstancesCommand::GlyphInstance> m_textInstances;
+    std::shared_ptr<ITexture> m_spTextInstancesTexture;
+    RenderCommandId m_textInstancesCommandId = RenderCommandId::text;
     uint32_t m_vertex_count = 0;
     uint32_t m_vertex_size = 6;
     std::shared_ptr<ITexture> m_spTexture;
@@ -171,6 +177,8 @@ public:
     void DrawLine(v2_t p0, v2_t p1, float width, xpf::Color color, LineOptions lineOptions);
 
 protected:
+    bool UsesInstancedText() const;
+    void PushTextInstance(const std::shared_ptr<ITexture>& spTexture, RenderCommandId commandId, const rectf_t& position, const rectf_t& texCoords, v4_t tint);
     void Push(v2_t pos, xpf::Color color);
     void Push3(v2_t p1, v2_t p2, v2_t p3, xpf::Color color);
     void PushQuad(v2_t p1, v2_t p2, v2_t p3, v2_t p4, xpf::Color color);
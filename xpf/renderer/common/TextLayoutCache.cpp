@@ -0,0 +1,95 @@
+#include "TextLayoutCache.h"
+#include "Font.h"
+#include <functional>
+
+namespace xpf {
+
+bool TextLayoutCache::Entry::Matches(std::string_view textIn, const TextDescription& description) const
+{
+    return
+        fontSize == description.fontSize &&
+        fontIndex == description.fontIndex &&
+        renderOptions == description.renderOptions &&
+        horizontalOrientation == description.horizontalOrientation &&
+        verticalOrientation == description.verticalOrientation &&
+        text == textIn &&
+        fontName == description.fontName;
+}
+
+/*static*/ size_t TextLayoutCache::Hash(std::string_view text, const TextDescription& description)
+{
+    size_t hash = std::hash<std::string_view>()(text);
+    auto combine = [&hash](size_t value) { hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+    combine(std::hash<std::string_view>()(description.fontName));
+    combine(size_t(uint16_t(description.fontSize)) | size_t(description.fontIndex) << 16);
+    combine(size_t(description.renderOptions) | size_t(description.horizontalOrientation) << 16 | size_t(description.verticalOrientation) << 24);
+    return hash;
+}
+
+/*static*/ const TextLayout* TextLayoutCache::Find(std::string_view text, const TextDescription& description)
+{
+    if (text.size() > c_maxTextLength)
+        return nullptr;
+
+    const auto iter = s_lookup.find(Hash(text, description));
+    if (iter == s_lookup.end())
+        return nullptr;
+
+    Entry& entry = *iter->second;
+    if (!entry.Matches(text, description) ||
+        entry.layout.atlasEpoch != GlyphAtlas::GetEpoch() ||
+        entry.layout.fontEpoch != Font::GetEpoch()) [[unlikely]]
+        return nullptr;
+
+    if (iter->second != s_entries.begin())
+        s_entries.splice(s_entries.begin(), s_entries, iter->second);
+
+    // keep the sheets this label draws from away from atlas eviction
+    for (const auto& quad : entry.layout.quads)
+        GlyphAtlas::Touch(quad.slot);
+
+    return &entry.layout;
+}
+
+/*static*/ TextLayout* TextLayoutCache::Add(std::string_view text, const TextDescription& description)
+{
+    if (text.empty() || text.size() > c_maxTextLength)
+        return nullptr;
+
+    const size_t hash = Hash(text, description);
+    auto iter = s_lookup.find(hash);
+    if (iter != s_lookup.end())
+    {
+        // stale layout or a hash collision, the newer text wins
+        s_entries.erase(iter->second);
+        s_lookup.erase(iter);
+    }
+    else if (s_entries.size() >= c_maxEntries)
+    {
+        s_lookup.erase(s_entries.back().hash);
+        s_entries.pop_back();
+    }
+
+    Entry& entry = s_entries.emplace_front();
+    entry.hash = hash;
+    entry.text = text;
+    entry.fontName = description.fontName;
+    entry.fontSize = description.fontSize;
+    entry.fontIndex = description.fontIndex;
+    entry.renderOptions = description.renderOptions;
+    entry.horizontalOrientation = description.horizontalOrientation;
+    entry.verticalOrientation = description.verticalOrientation;
+    entry.layout.atlasEpoch = GlyphAtlas::GetEpoch();
+    entry.layout.fontEpoch = Font::GetEpoch();
+    s_lookup[hash] = s_entries.begin();
+
+    return &entry.layout;
+}
+
+/*static*/ void TextLayoutCache::Clear()
+{
+    s_lookup.clear();
+    s_entries.clear();
+}
+
+} // xpf
@@ -0,0 +1,75 @@
+#pragma once
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <core/Rectangle.h>
+#include <renderer/common/GlyphAtlas.h>
+#include <renderer/common/RenderBatchBuilder.h>
+
+namespace xpf {
+
+struct TextLayoutQuad
+{
+    rectf_t position;      // relative to the x,y given to DrawText
+    rectf_t texCoords;
+    std::shared_ptr<ITexture> spTexture;
+    GlyphAtlasSlot slot;
+};
+
+// Positioned glyph quads of one DrawText call, alignment already applied.
+struct TextLayout
+{
+    std::vector<TextLayoutQuad> quads;
+    rectf_t bounds;        // relative to the x,y given to DrawText, used for the background
+    RenderCommandId commandId = RenderCommandId::text;
+    uint32_t atlasEpoch = 0;
+    uint32_t fontEpoch = 0;
+};
+
+// Bounded LRU cache of texture rendered DrawText layouts, so labels drawn every frame
+// skip font lookup, measuring and codepoint decoding and only translate their quads.
+// Layouts are dropped when the glyph atlas changes (GlyphAtlas::GetEpoch) or a
+// background font load lands (Font::GetEpoch).
+class TextLayoutCache
+{
+protected:
+    struct Entry
+    {
+        size_t hash = 0;
+        std::string text;
+        std::string fontName;
+        int16_t fontSize = 0;
+        uint16_t fontIndex = 0;
+        FontRenderOptions renderOptions = FontRenderOptions::Texture;
+        HorizontalOrientation horizontalOrientation = HorizontalOrientation::Left;
+        VerticalOrientation verticalOrientation = VerticalOrientation::Top;
+        TextLayout layout;
+
+        bool Matches(std::string_view text, const TextDescription& description) const;
+    };
+
+    static constexpr size_t c_maxEntries = 1024;
+    static constexpr size_t c_maxTextLength = 256; // longer text is rarely a repeated label
+
+    static inline std::list<Entry> s_entries; // most recently used first
+    static inline std::unordered_map<size_t, std::list<Entry>::iterator> s_lookup;
+
+public:
+    TextLayoutCache() = delete;
+
+    // layout from a previous call with the same text and description, nullptr if none or stale
+    static const TextLayout* Find(std::string_view text, const TextDescription& description);
+
+    // empty layout to fill while drawing, nullptr if the text should not be cached
+    static TextLayout* Add(std::string_view text, const TextDescription& description);
+
+    static void Clear();
+
+protected:
+    static size_t Hash(std::string_view text, const TextDescription& description);
+};
+
+} // xpf
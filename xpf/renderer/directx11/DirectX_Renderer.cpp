@@ -1,4 +1,6 @@
 #include <renderer/common/Common_Renderer.h>
+#include <renderer/common/FontLoader.h>
+#include <renderer/common/GlyphAtlas.h>
 #include <renderer/ITexture.h>
 #include <core/Image.h>
 #include <core/Log.h>
@@ -117,11 +119,13 @@ public:
         return m_pWindow;
     }
 
-    virtual void Shutdown() override { Cleanup(); }
+    virtual void Shutdown() override { Font::SaveGlyphCaches(); Cleanup(); }
     virtual void Render() override
     {
         m_frame_count++;
         m_renderStats = {};
+        FontLoader::RunCompleted();
+        GlyphAtlas::CommitPending();
 
         // static float tt = 0;
         // tt += .01;
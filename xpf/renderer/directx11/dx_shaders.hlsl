@@ -112,6 +112,12 @@ float4 ps_main(VS_Output input) : SV_TARGET
     {
         pixel = input.color * mytexture.Sample(textSampler, input.uv).r;
     }
+    else if (commandId == 13) // text_distance_field, outline sits at 0.5
+    {
+        float dist = mytexture.Sample(mysampler, input.uv).r;
+        float w = fwidth(dist);
+        pixel = input.color * smoothstep(0.5 - w, 0.5 + w, dist);
+    }
     else if (commandId == 4) // rounded_rectangle
     {
         float width_2 = width * .5;
@@ -1,4 +1,6 @@
 #include <common/Common_Renderer.h>
+#include <common/FontLoader.h>
+#include <common/GlyphAtlas.h>
 #include <core/Color.h>
 #include <core/Image.h>
 #include <core/Log.h>
@@ -122,7 +124,7 @@ public:
         return m_pWindow;
     }
 
-    virtual void Shutdown() override {}
+    virtual void Shutdown() override { Font::SaveGlyphCaches(); }
 
     virtual void OnResize(int32_t width, int32_t height) override
     {
@@ -232,6 +234,8 @@ public:
     virtual void Render() override
     {
         m_frame_count++;
+        FontLoader::RunCompleted();
+        GlyphAtlas::CommitPending();
         #pragma pack(push)
         #pragma pack(1)
         struct VertexData
@@ -22,16 +22,18 @@ public:
     const textureid_t m_textureid;
     const uint32_t m_width;
     const uint32_t m_height;
+    const uint32_t m_bytesPerPixel;
     rectf_t m_textCoords;
     const ITexture::Interpolation m_interpolation;
     static inline textureid_t s_id = 0;
 
 public:
-    MetalTexture(id<MTLTexture> texture, uint32_t width, uint32_t height, Interpolation interpolation, rectf_t region)
+    MetalTexture(id<MTLTexture> texture, uint32_t width, uint32_t height, uint32_t bytesPerPixel, Interpolation interpolation, rectf_t region)
         : m_texture(texture)
         , m_textureid(+s_id)
         , m_width(width)
         , m_height(height)
+        , m_bytesPerPixel(bytesPerPixel)
         , m_textCoords(region)
         , m_interpolation(interpolation)
          {}
@@ -45,10 +47,21 @@ public:
 
     virtual std::shared_ptr<ITexture> SampledTexture(Interpolation interpolation, rectf_t region) const override
     {
-        return std::make_shared<MetalTexture>(m_texture, m_width, m_height, interpolation, region);
+        return std::make_shared<MetalTexture>(m_texture, m_width, m_height, m_bytesPerPixel, interpolation, region);
     }
 
     virtual void SetRegion(rectf_t region) override { m_textCoords = region; }
+
+    virtual void UpdatePixels(recti_t region, const byte_t* pdata, uint32_t rowLength) override
+    {
+        if (region.w <= 0 || region.h <= 0)
+            return;
+
+        [m_texture replaceRegion: MTLRegionMake2D(region.x, region.y, region.w, region.h)
+                     mipmapLevel: 0
+                       withBytes: pdata
+                     bytesPerRow: rowLength * m_bytesPerPixel];
+    }
 };
 
 id<MTLTexture> GetMTLTexture(const ITexture* pTexture)
@@ -103,6 +116,7 @@ std::shared_ptr<ITexture> Metal_CreateTexture(id<MTLDevice> device, const Image&
     return std::make_shared<MetalTexture>(
         texture,
         image.GetWidth(), image.GetHeight(),
+        bytesPerPixel,
         ITexture::Interpolation::None,
         rectf_t{0,0,1,1});
 }
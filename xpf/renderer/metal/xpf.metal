@@ -571,6 +571,17 @@ fragment float4 fragmentShader(
         // return the color of the texture
         return float4(in.color.rgb, colorSample.r);
     }
+    else if (fragData.commandId == 13) // text_distance_field, outline sits at 0.5
+    {
+        constexpr sampler linearTextureSampler (
+            coord::normalized,
+            mag_filter::linear,
+            min_filter::linear);
+
+        const float dist = colorTexture.sample(linearTextureSampler, in.textureCoordinate).r;
+        const float w = fwidth(dist);
+        return float4(in.color.rgb, smoothstep(0.5 - w, 0.5 + w, dist));
+    }
     else if (fragData.commandId == 4) // rounded_rectangle
     {
         float scaler = fragData.height > fragData.width ? fragData.height : fragData.width;
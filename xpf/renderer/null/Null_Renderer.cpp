@@ -21,6 +21,7 @@ public:
     virtual Interpolation GetInterpolation() const override { return Interpolation::None; }
     virtual std::shared_ptr<ITexture> SampledTexture(Interpolation /*interpolation*/, rectf_t /*region*/) const override { return nullptr; }
     virtual void SetRegion(rectf_t /*region*/) override { };
+    virtual void UpdatePixels(recti_t /*region*/, const byte_t* /*pdata*/, uint32_t /*rowLength*/) override { };
 };
 
 class NullBuffer : public IBuffer
@@ -30,12 +30,15 @@ public:
 
 std::shared_ptr<IBuffer> OpenGL_CreateBuffer(const byte_t* pbyte, size_t size)
 {
+    // the glyph shader reads 32 bit words, pad the tail to a whole one.
+    // bound as shader storage at draw time, see OpenGLRenderer::UseGlyphShader
+    const size_t paddedSize = (size + 3) & ~size_t(3);
     uint32_t id = 0;
     glGenBuffers(1, &id);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, size, pbyte, GL_DYNAMIC_DRAW);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, id);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0); // unbind
+    glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+    glBufferData(GL_COPY_WRITE_BUFFER, paddedSize, nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, size, pbyte);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0); // unbind
     return std::make_shared<OpenGLBuffer>(id, size);
 }
 } // xpf
@@ -1,4 +1,6 @@
 #include <common/Common_Renderer.h>
+#include <common/FontLoader.h>
+#include <common/GlyphAtlas.h>
 #include <opengl/Shader.h>
 #include <core/Image.h>
 
@@ -7,10 +9,13 @@
 #include <GLFW/glfw3native.h>
 #include <renderer/IRenderer.h>
 #include <renderer/ITexture.h>
+#include <cstddef>
 
 namespace xpf::resources {
 std::string_view opengl_shader_vert();
 std::string_view opengl_shader_frag();
+std::string_view opengl_glyph_shader_vert();
+std::string_view opengl_glyph_shader_frag();
 }
 
 namespace xpf {
@@ -30,17 +35,34 @@ protected:
     vao_t m_vao = 0;
     vbo_t m_vbo = 0;
     ebo_t m_ebo = 0;
+    vao_t m_textVao = 0;         // unit quad plus glyph instances
+    vbo_t m_textQuadVbo = 0;
+    vbo_t m_textInstanceVbo = 0;
+    xpf::Shader m_glyphShader;  // vector glyphs, only where shader storage buffers are available
+    vao_t m_glyphVao = 0;
+    vbo_t m_glyphInstanceVbo = 0;
 
     // vertex shader
     static inline int32_t u_projection;
     static inline int32_t u_view_matrix;
     static inline int32_t u_transform;
+    static inline int32_t u_instanced;
+    static inline int32_t u_glyph_size_scale;
     static inline int32_t u_command_id;
     static inline int32_t u_corner_radius;
     static inline int32_t u_border_thickness;
     static inline int32_t u_border_color;
     static inline int32_t u_size;
 
+    // glyph shader
+    static inline int32_t u_glyph_projection;
+    static inline int32_t u_glyph_view_matrix;
+    static inline int32_t u_glyph_transform;
+    static inline int32_t u_glyph_instanced;
+    static inline int32_t u_glyph_command_id;
+    static inline int32_t u_glyph_scale;
+    static inline int32_t u_glyph_data_offset;
+
 public:
     OpenGLRenderer() = default;
 
@@ -49,6 +71,11 @@ public:
         if (m_vbo != 0) glDeleteBuffers(1, &m_vbo);
         if (m_ebo != 0) glDeleteBuffers(1, &m_ebo);
         if (m_vao != 0) glDeleteVertexArrays(1, &m_vao);
+        if (m_textQuadVbo != 0) glDeleteBuffers(1, &m_textQuadVbo);
+        if (m_textInstanceVbo != 0) glDeleteBuffers(1, &m_textInstanceVbo);
+        if (m_textVao != 0) glDeleteVertexArrays(1, &m_textVao);
+        if (m_glyphInstanceVbo != 0) glDeleteBuffers(1, &m_glyphInstanceVbo);
+        if (m_glyphVao != 0) glDeleteVertexArrays(1, &m_glyphVao);
     }
 
     virtual GLFWwindow* Initialize(RendererOptions&& optionsIn) override
@@ -73,13 +100,16 @@ public:
         }
 
         LoadShader();
+        m_options.capabilities |= RendererCapability::InstancedTexturedText;
+        if (LoadGlyphShader())
+            m_options.capabilities |= RendererCapability::ShaderRenderedText | RendererCapability::ShaderInstancedRenderedText;
 
         glfwSwapInterval(m_options.enable_vsync ? 1 : 0);
 
         return m_pWindow;
     }
 
-    virtual void Shutdown() override {}
+    virtual void Shutdown() override { Font::SaveGlyphCaches(); }
 
     virtual void OnResize(int32_t width, int32_t height) override
     {
@@ -91,7 +121,10 @@ public:
     {
         m_frame_count++;
         m_renderStats = {};
+        FontLoader::RunCompleted();
+        GlyphAtlas::CommitPending();
         const ITexture* pCurrentTexture = nullptr;
+        const IBuffer* pCurrentBuffer = nullptr;
 
         m4_t transform = m4_t::identity;
         std::vector<m4_t> transforms({transform});
@@ -144,24 +177,36 @@ public:
             else
             {
                 const RenderDrawCommand& command = *static_cast<RenderDrawCommand*>(spCommand.get());
-                glUseProgram(m_shader.id());
-                // for vertex shader
-                xpf::Shader::set_uniform(u_projection, m_projection_matrix);
-                xpf::Shader::set_uniform(u_view_matrix, m4_t::identity);
-                xpf::Shader::set_uniform(u_transform, transform);
-
-                // for frag shader
-                xpf::Shader::set_uniform(u_command_id, int32_t(command.commandId));
-
-                if (spCommand->commandId == RenderCommandId::rounded_rectangle ||
-                    spCommand->commandId == RenderCommandId::rounded_rectangle_with_border ||
-                    spCommand->commandId == RenderCommandId::rounded_rectangle_with_border_dots)
+                const bool isGlyph = command.commandId == RenderCommandId::glyph || command.commandId == RenderCommandId::glyphs;
+                if (isGlyph)
+                {
+                    UseGlyphShader(command, transform, pCurrentBuffer);
+                }
+                else
                 {
-                    const RenderRoundedRectangleCommand& cmd = *static_cast<RenderRoundedRectangleCommand*>(spCommand.get());
-                    xpf::Shader::set_uniform(u_size, cmd.size);
-                    xpf::Shader::set_uniform(u_corner_radius, cmd.cornerRadius.v);
-                    xpf::Shader::set_uniform(u_border_thickness, cmd.borderThickness.get_v4());
-                    xpf::Shader::set_uniform(u_border_color, cmd.borderColor);
+                    glUseProgram(m_shader.id());
+                    // for vertex shader
+                    xpf::Shader::set_uniform(u_projection, m_projection_matrix);
+                    xpf::Shader::set_uniform(u_view_matrix, m4_t::identity);
+                    xpf::Shader::set_uniform(u_transform, transform);
+                    xpf::Shader::set_uniform(u_instanced, int32_t(command.commandId == RenderCommandId::text_instanced));
+
+                    // for frag shader
+                    if (command.commandId == RenderCommandId::text_instanced)
+                        xpf::Shader::set_uniform(u_command_id, int32_t(static_cast<const RenderTextInstancesCommand&>(command).glyphCommandId));
+                    else
+                        xpf::Shader::set_uniform(u_command_id, int32_t(command.commandId));
+
+                    if (spCommand->commandId == RenderCommandId::rounded_rectangle ||
+                        spCommand->commandId == RenderCommandId::rounded_rectangle_with_border ||
+                        spCommand->commandId == RenderCommandId::rounded_rectangle_with_border_dots)
+                    {
+                        const RenderRoundedRectangleCommand& cmd = *static_cast<RenderRoundedRectangleCommand*>(spCommand.get());
+                        xpf::Shader::set_uniform(u_size, cmd.size);
+                        xpf::Shader::set_uniform(u_corner_radius, cmd.cornerRadius.v);
+                        xpf::Shader::set_uniform(u_border_thickness, cmd.borderThickness.get_v4());
+                        xpf::Shader::set_uniform(u_border_color, cmd.borderColor);
+                    }
                 }
 
                 if (command.spTexture != nullptr) {
@@ -186,6 +231,24 @@ public:
                     }
                 }
 
+                if (!clipRegions.empty())
+                {
+                    auto clipRect = clipRegions.back();
+                    glScissor(clipRect.x, m_options.height - clipRect.y - clipRect.h, clipRect.w, clipRect.h);
+                }
+
+                if (command.commandId == RenderCommandId::text_instanced)
+                {
+                    DrawTextInstances(static_cast<const RenderTextInstancesCommand&>(command));
+                    return;
+                }
+
+                if (command.commandId == RenderCommandId::glyphs)
+                {
+                    DrawGlyphInstances(static_cast<const RenderGlyphsCommand&>(command));
+                    return;
+                }
+
                 uint32_t vertex_size = 8;
 
                 if (m_vao == 0)
@@ -212,12 +275,6 @@ public:
                 glEnableVertexAttribArray(2);
                 glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vertex_size * sizeof(float), (void*)(6 * sizeof(float)));
 
-                if (!clipRegions.empty())
-                {
-                    auto clipRect = clipRegions.back();
-                    glScissor(clipRect.x, m_options.height - clipRect.y - clipRect.h, clipRect.w, clipRect.h);
-                }
-
                 glBindVertexArray(m_vao);
                 glDrawArrays(GL_TRIANGLES, 0, command.count);
                 m_renderStats.vertexCount += command.count;
@@ -264,6 +321,132 @@ public:
         return OpenGL_CreateBuffer(pbyte, size);
     }
 protected:
+    void DrawTextInstances(const RenderTextInstancesCommand& command)
+    {
+        typedef RenderTextInstancesCommand::GlyphInstance GlyphInstance;
+
+        if (m_textVao == 0)
+        {
+            // two triangles of the unit quad, every glyph is one instance of it
+            static constexpr float c_unitQuad[] = {0,0, 1,0, 1,1, 1,1, 0,1, 0,0};
+            glGenVertexArrays(1, &m_textVao);
+            glBindVertexArray(m_textVao);
+
+            glGenBuffers(1, &m_textQuadVbo);
+            glBindBuffer(GL_ARRAY_BUFFER, m_textQuadVbo);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(c_unitQuad), c_unitQuad, GL_STATIC_DRAW);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+
+            glGenBuffers(1, &m_textInstanceVbo);
+            glBindBuffer(GL_ARRAY_BUFFER, m_textInstanceVbo);
+
+            // origin vec2
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, left));
+            glVertexAttribDivisor(3, 1);
+
+            // size vec2, fixed point
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 2, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, width));
+            glVertexAttribDivisor(4, 1);
+
+            // texture coords vec4, normalized
+            glEnableVertexAttribArray(5);
+            glVertexAttribPointer(5, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, u0));
+            glVertexAttribDivisor(5, 1);
+
+            // color vec4, normalized
+            glEnableVertexAttribArray(6);
+            glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, r));
+            glVertexAttribDivisor(6, 1);
+        }
+
+        glBindVertexArray(m_textVao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_textInstanceVbo);
+        glBufferData(GL_ARRAY_BUFFER, command.instances.size() * sizeof(GlyphInstance), command.instances.data(), GL_STREAM_DRAW);
+        xpf::Shader::set_uniform(u_glyph_size_scale, 1.0f / RenderTextInstancesCommand::c_sizeScale);
+
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, command.count);
+        m_renderStats.vertexCount += 6 * command.count;
+        m_renderStats.drawCount++;
+    }
+
+    void UseGlyphShader(const RenderDrawCommand& command, const m4_t& transform, const IBuffer*& pCurrentBuffer)
+    {
+        glUseProgram(m_glyphShader.id());
+        xpf::Shader::set_uniform(u_glyph_projection, m_projection_matrix);
+        xpf::Shader::set_uniform(u_glyph_view_matrix, m4_t::identity);
+        xpf::Shader::set_uniform(u_glyph_transform, transform);
+        xpf::Shader::set_uniform(u_glyph_instanced, int32_t(command.commandId == RenderCommandId::glyphs));
+        xpf::Shader::set_uniform(u_glyph_command_id, int32_t(command.commandId));
+
+        const IBuffer* pBuffer = nullptr;
+        if (command.commandId == RenderCommandId::glyphs)
+        {
+            const RenderGlyphsCommand& cmd = static_cast<const RenderGlyphsCommand&>(command);
+            xpf::Shader::set_uniform(u_glyph_scale, cmd.scale);
+            pBuffer = cmd.spBuffer.get();
+        }
+        else
+        {
+            const RenderGlyphCommand& cmd = static_cast<const RenderGlyphCommand&>(command);
+            xpf::Shader::set_uniform(u_glyph_scale, cmd.scale);
+            xpf::Shader::set_uniform(u_glyph_data_offset, int32_t(cmd.glyphStartOffset));
+            pBuffer = cmd.spBuffer.get();
+        }
+
+        // the page's outlines, see Font::CommitPage
+        if (pBuffer != nullptr && pCurrentBuffer != pBuffer)
+        {
+            pCurrentBuffer = pBuffer;
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, pBuffer->GetId());
+            m_renderStats.bufferSwitches++;
+        }
+    }
+
+    void DrawGlyphInstances(const RenderGlyphsCommand& command)
+    {
+        typedef RenderGlyphsCommand::GlyphsInstanceData GlyphsInstanceData;
+
+        if (m_glyphVao == 0)
+        {
+            // no per vertex data, the vertex shader picks the corner of the glyph from gl_VertexID
+            glGenVertexArrays(1, &m_glyphVao);
+            glBindVertexArray(m_glyphVao);
+
+            glGenBuffers(1, &m_glyphInstanceVbo);
+            glBindBuffer(GL_ARRAY_BUFFER, m_glyphInstanceVbo);
+
+            // color vec4
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(GlyphsInstanceData), (void*)offsetof(GlyphsInstanceData, color));
+            glVertexAttribDivisor(3, 1);
+
+            // left, top, right, bottom vec4
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(GlyphsInstanceData), (void*)offsetof(GlyphsInstanceData, left));
+            glVertexAttribDivisor(4, 1);
+
+            // bearingX, width, bearingY, height ivec4
+            glEnableVertexAttribArray(5);
+            glVertexAttribIPointer(5, 4, GL_INT, sizeof(GlyphsInstanceData), (void*)offsetof(GlyphsInstanceData, bearingX));
+            glVertexAttribDivisor(5, 1);
+
+            // start of the glyph in the page buffer
+            glEnableVertexAttribArray(6);
+            glVertexAttribIPointer(6, 1, GL_UNSIGNED_INT, sizeof(GlyphsInstanceData), (void*)offsetof(GlyphsInstanceData, dataStart));
+            glVertexAttribDivisor(6, 1);
+        }
+
+        glBindVertexArray(m_glyphVao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_glyphInstanceVbo);
+        glBufferData(GL_ARRAY_BUFFER, command.instanceData.size() * sizeof(GlyphsInstanceData), command.instanceData.data(), GL_STREAM_DRAW);
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, command.glyphCount);
+        m_renderStats.vertexCount += 4 * command.glyphCount;
+        m_renderStats.drawCount++;
+    }
 
     void LoadShader()
     {
@@ -274,6 +457,8 @@ protected:
         u_projection = m_shader.get_uniform_location("u_projection");
         u_view_matrix = m_shader.get_uniform_location("u_view_matrix");
         u_transform = m_shader.get_uniform_location("u_transform");
+        u_instanced = m_shader.get_uniform_location("u_instanced");
+        u_glyph_size_scale = m_shader.get_uniform_location("u_glyph_size_scale");
 
         u_command_id = m_shader.get_uniform_location("u_command_id");
         u_corner_radius = m_shader.get_uniform_location("u_corner_radius");
@@ -281,6 +466,26 @@ protected:
         u_border_color = m_shader.get_uniform_location("u_border_color");
         u_size = m_shader.get_uniform_location("u_size");
     }
+
+    // vector glyphs read the outlines from a shader storage buffer, core since 4.3
+    bool LoadGlyphShader()
+    {
+        if (!GLAD_GL_VERSION_4_3)
+            return false;
+
+        m_glyphShader = xpf::Shader::load({
+            {xpf::Shader::vertex, xpf::resources::opengl_glyph_shader_vert()},
+            {xpf::Shader::fragment, xpf::resources::opengl_glyph_shader_frag()}});
+
+        u_glyph_projection = m_glyphShader.get_uniform_location("u_projection");
+        u_glyph_view_matrix = m_glyphShader.get_uniform_location("u_view_matrix");
+        u_glyph_transform = m_glyphShader.get_uniform_location("u_transform");
+        u_glyph_instanced = m_glyphShader.get_uniform_location("u_instanced");
+        u_glyph_command_id = m_glyphShader.get_uniform_location("u_command_id");
+        u_glyph_scale = m_glyphShader.get_uniform_location("u_scale");
+        u_glyph_data_offset = m_glyphShader.get_uniform_location("u_data_offset");
+        return true;
+    }
 };
 
 std::unique_ptr<IRenderer> create_opengl_renderer()
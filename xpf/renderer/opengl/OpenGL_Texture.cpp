@@ -9,6 +9,8 @@
 
 namespace xpf {
 
+static std::tuple<uint32_t, uint32_t, uint32_t> GetOpenGLTextureFormats(PixelFormat pixelFormat);
+
 class OpenGLTexture : public ITexture
 {
 protected:
@@ -47,6 +49,20 @@ public:
 
     virtual void SetRegion(rectf_t region) override { m_textCoords = region; }
 
+    virtual void UpdatePixels(recti_t region, const byte_t* pdata, uint32_t rowLength) override
+    {
+        const auto [glInternalFormat, glFormat, glType] = GetOpenGLTextureFormats(m_pixelFormat);
+        if (glInternalFormat == 0 || region.w <= 0 || region.h <= 0)
+            return;
+
+        glBindTexture(GL_TEXTURE_2D, m_id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, region.x, region.y, region.w, region.h, glFormat, glType, pdata);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
     Type GetType() const { return m_type; }
     uint32_t GetMipMapCount() const { return m_mipMapCount; }
     PixelFormat GetPixelFormat() const { return m_pixelFormat; }
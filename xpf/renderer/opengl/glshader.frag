@@ -82,6 +82,12 @@ void main() {
         FragColor = texture(texture0, frag_texture_coord) * frag_color;
     else if (u_command_id == 3) // text
         FragColor = vec4(frag_color.rgb, texture(texture0, frag_texture_coord).r);
+    else if (u_command_id == 13) // text_distance_field, outline sits at 0.5
+    {
+        float dist = texture(texture0, frag_texture_coord).r;
+        float w = fwidth(dist);
+        FragColor = vec4(frag_color.rgb, smoothstep(0.5 - w, 0.5 + w, dist));
+    }
     else if (u_command_id == 4) // rounded_rectangle
     {
         float scaler = u_size.y > u_size.x ? u_size.y : u_size.x;
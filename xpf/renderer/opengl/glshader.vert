@@ -2,15 +2,30 @@
 layout (location = 0) in vec2 aPos;
 layout (location = 1) in vec4 aColor;
 layout (location = 2) in vec2 aTextureCoord;
+// per instance, see RenderTextInstancesCommand
+layout (location = 3) in vec2 aGlyphOrigin;
+layout (location = 4) in vec2 aGlyphSize;
+layout (location = 5) in vec4 aGlyphTextureCoords;
+layout (location = 6) in vec4 aGlyphColor;
 uniform mat4 u_projection;
 uniform mat4 u_view_matrix;
 uniform mat4 u_transform;
+uniform int u_instanced;
+uniform float u_glyph_size_scale;
 
 out vec4 frag_color;
 out vec2 frag_texture_coord;
 
 void main() {
-    frag_color = aColor;
-    frag_texture_coord = aTextureCoord;
-    gl_Position = u_projection * u_view_matrix * u_transform * vec4(aPos.x, aPos.y, 0.0, 1.0);
+    vec2 pos = aPos;
+    if (u_instanced != 0) {
+        // aPos is a corner of the unit quad
+        pos = aGlyphOrigin + aPos * aGlyphSize * u_glyph_size_scale;
+        frag_color = aGlyphColor;
+        frag_texture_coord = mix(aGlyphTextureCoords.xy, aGlyphTextureCoords.zw, aPos);
+    } else {
+        frag_color = aColor;
+        frag_texture_coord = aTextureCoord;
+    }
+    gl_Position = u_projection * u_view_matrix * u_transform * vec4(pos.x, pos.y, 0.0, 1.0);
 }
@@ -0,0 +1,178 @@
+#version 430 core
+in vec4 frag_color;
+in vec2 frag_texture_coord;
+flat in uint frag_data_offset;
+out vec4 FragColor;
+
+uniform int u_command_id;
+uniform float u_scale;      // font units to pixels
+uniform int u_data_offset;  // start of the glyph in the page buffer, RenderCommandId::glyph only
+
+// the page's outlines or triangles as 'short's, see Font::AppendGlyphOutline & Font::AppendGlyphTriangles
+layout (std430, binding = 0) readonly buffer GlyphData { int glyph_data[]; };
+
+int read_short(int index)
+{
+    return bitfieldExtract(glyph_data[index >> 1], (index & 1) * 16, 16);
+}
+
+vec2 read_point(int index)
+{
+    return vec2(read_short(index), read_short(index + 1));
+}
+
+float cross2(vec2 a, vec2 b) { return a.x * b.y - a.y * b.x; }
+
+vec2 barycentric2D(vec2 p, vec2 a, vec2 b, vec2 c)
+{
+    vec2 v0 = b - a;
+    vec2 v1 = c - a;
+    vec2 v2 = p - a;
+    float den = 1.0 / cross2(v0, v1);
+    return vec2(cross2(v2, v1) * den, cross2(v0, v2) * den);
+}
+
+// outline: length { count x y ... } bezierCount { x0 y0 x1 y1 x2 y2 ... }
+float isInsidePath(vec2 uv, int start)
+{
+    int dataLength = read_short(start);
+    int winding = 0;
+    int x1 = 0, y1 = 0;
+    int count = 0;
+
+    for (int i = start + 1; i < start + dataLength; i += 2)
+    {
+        if (count == 0)
+        {
+            count = read_short(i);
+            i++;
+            x1 = read_short(i);
+            y1 = read_short(i + 1);
+            count--;
+            continue;
+        }
+
+        int x2 = read_short(i);
+        int y2 = read_short(i + 1);
+        count--;
+
+        if ((y1 <= uv.y && uv.y < y2) || (y2 <= uv.y && uv.y < y1))
+        {
+            float px = x1;
+            if (x1 != x2) // diagonal line
+            {
+                float m = float(y1 - y2) / float(x1 - x2);
+                float b = y1 - m * x1;
+                px = (uv.y - b) / m;
+            }
+
+            if (uv.x > px)
+                winding += (y1 < y2) ? -1 : 1;
+        }
+
+        x1 = x2;
+        y1 = y2;
+    }
+
+    int p = start + dataLength;
+    int bezierCount = read_short(p++);
+    for (int i = 0; i < bezierCount; i++, p += 6)
+    {
+        vec2 bc = barycentric2D(uv, read_point(p), read_point(p + 2), read_point(p + 4));
+        float s = bc.x;
+        float t = bc.y;
+        if (s >= 0 && t >= 0 && (s + t) <= 1)
+        {
+            float d = (s * .5 + t);
+            if ((d * d) < t)
+                return winding == 0 ? 1.0 : 0.0;
+        }
+    }
+
+    return winding != 0 ? 1.0 : 0.0;
+}
+
+// triangles: contourCount { type length { x0 y0 x1 y1 x2 y2 ... } }
+float DrawTris(vec2 uv, int start)
+{
+    int contourCount = read_short(start);
+    int p = start + 1;
+    int winding = 0;
+
+    for (int contour = 0; contour < contourCount; contour++)
+    {
+        int type = read_short(p);
+        int length = read_short(p + 1);
+        p += 2;
+
+        for (int i = 0; i < length; i += 6)
+        {
+            vec2 bc = barycentric2D(uv, read_point(p + i), read_point(p + i + 2), read_point(p + i + 4));
+            float s = bc.x;
+            float t = bc.y;
+            if ((s + t) <= 1 && s >= 0 && t >= 0)
+            {
+                // type 0 is solid, -1 & 1 are quadratic bezier curves bending either way
+                float d = (s * .5 + t);
+                if (type == 0 || ((d * d) - t) * type >= 0)
+                {
+                    winding++;
+                    break;
+                }
+            }
+        }
+
+        p += length;
+    }
+
+    return float(winding % 2);
+}
+
+float coverage(vec2 pos, int glyphType, int start)
+{
+    return glyphType == 1 ? DrawTris(pos, start) : isInsidePath(pos, start);
+}
+
+vec4 drawGlyph(vec2 pos, vec4 color, int dataOffset, float scale)
+{
+    int glyphType = read_short(0);
+    float six = 1.0 / (6.0 * scale);
+    float twl = 1.0 / (12.0 * scale);
+    pos += .5;
+    // __________
+    // |  |  | *|
+    // | *|  |  |
+    // |--|--|--|
+    // |  | *|  |
+    // |  |  |* |
+    // |--|--|--|
+    // |* |  |  |
+    // |  |* |  |
+    // |__|__|__|
+    //
+    float red = 0; float green = 0; float blue = 0;
+    // 1st row
+    red += coverage(pos + vec2(six+six+twl, -(six+six+twl)), glyphType, dataOffset);
+    red += coverage(pos + vec2(-(six+twl), -(six+twl)), glyphType, dataOffset);
+    // 2nd row
+    green += coverage(pos + vec2(twl, -twl), glyphType, dataOffset);
+    green += coverage(pos + vec2(six+twl, twl), glyphType, dataOffset);
+    // 3rd row
+    blue += coverage(pos + vec2(-(six+six+twl), (six+twl)), glyphType, dataOffset);
+    blue += coverage(pos + vec2(-(twl), (six+six+twl)), glyphType, dataOffset);
+
+    float intensity = (red + green + blue) / 6.0;
+    float rg = (1 - (red + green) / 4.0);
+    float rgb = (1 - intensity);
+    float gb = (1 - (green + blue) / 4.0);
+    intensity = 1 - (rg + rgb + gb) / 3.0;
+
+    return vec4(color.rgb, color.a * intensity);
+}
+
+void main() {
+    if (u_command_id == 11) // glyphs
+        FragColor = drawGlyph(frag_texture_coord, frag_color, int(frag_data_offset), u_scale);
+    else // glyph
+        FragColor = drawGlyph(frag_texture_coord, frag_color, u_data_offset, u_scale);
+}
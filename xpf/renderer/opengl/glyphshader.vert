@@ -0,0 +1,35 @@
+#version 430 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec4 aColor;
+layout (location = 2) in vec2 aTextureCoord;
+// per instance, see RenderGlyphsCommand::GlyphsInstanceData
+layout (location = 3) in vec4 aGlyphColor;
+layout (location = 4) in vec4 aGlyphBounds;      // left, top, right, bottom
+layout (location = 5) in ivec4 aGlyphBox;        // bearingX, width, bearingY, height in font units
+layout (location = 6) in uint aGlyphDataOffset;
+uniform mat4 u_projection;
+uniform mat4 u_view_matrix;
+uniform mat4 u_transform;
+uniform int u_instanced;
+
+out vec4 frag_color;
+out vec2 frag_texture_coord; // position inside the glyph in font units
+flat out uint frag_data_offset;
+
+void main() {
+    vec2 pos = aPos;
+    if (u_instanced != 0) {
+        // triangle strip: top left, top right, bottom left, bottom right
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        pos = mix(aGlyphBounds.xy, aGlyphBounds.zw, corner);
+        pos.x = floor(pos.x) + .5;
+        frag_color = aGlyphColor;
+        frag_texture_coord = vec2(aGlyphBox.xz) + vec2(aGlyphBox.yw) * corner;
+        frag_data_offset = aGlyphDataOffset;
+    } else {
+        frag_color = aColor;
+        frag_texture_coord = aTextureCoord;
+        frag_data_offset = 0u;
+    }
+    gl_Position = u_projection * u_view_matrix * u_transform * vec4(pos.x, pos.y, 0.0, 1.0);
+}
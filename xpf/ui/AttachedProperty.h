@@ -1,11 +1,16 @@
 #pragma once
 #include <stdint.h>
+#include <array>
 #include <memory>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace xpf {
 
-struct AttachedPropertyBase {};
+struct AttachedPropertyBase
+{
+    virtual ~AttachedPropertyBase() = default;
+};
 
 template<typename T, size_t Tid>
 struct AttachedProperty : public AttachedPropertyBase {
@@ -20,46 +25,88 @@ template<typename TBase>
 class ObjectWithAttachedProperties : public TBase
 {
 protected:
-    std::unordered_map<size_t, std::unique_ptr<AttachedPropertyBase>> m_attachedProperties;
+    typedef std::pair<size_t, std::unique_ptr<AttachedPropertyBase>> AttachedEntry; // id 0: free slot
+
+    // elements carry a couple of attached properties at most, those are kept inline
+    static constexpr size_t c_inlineAttachedProperties = 2;
+    std::array<AttachedEntry, c_inlineAttachedProperties> m_attachedProperties;
+    std::vector<AttachedEntry> m_moreAttachedProperties;
 
 public:
     template<typename T> void Remove()
     {
-        m_attachedProperties.erase(T::Id());
+        AttachedEntry* pentry = Find(T::Id());
+        if (pentry == nullptr)
+            return;
+
+        if (pentry < m_attachedProperties.data() || pentry >= m_attachedProperties.data() + m_attachedProperties.size())
+        {
+            std::swap(*pentry, m_moreAttachedProperties.back());
+            m_moreAttachedProperties.pop_back();
+            return;
+        }
+
+        pentry->first = 0;
+        pentry->second.reset();
     }
 
     template<typename T> ObjectWithAttachedProperties& Set(T&& item)
     {
-        m_attachedProperties[T::Id()] = std::make_unique<T>(std::move(item));
+        AttachedEntry* pentry = Find(T::Id());
+        if (pentry == nullptr)
+            pentry = Find(0);
+        if (pentry == nullptr)
+            pentry = &m_moreAttachedProperties.emplace_back();
+
+        pentry->first = T::Id();
+        pentry->second = std::make_unique<T>(std::move(item));
         return *this;
     }
 
     template<typename T> const typename T::value_type& GetValueOr(const T::value_type& value) const
     {
-        auto iter = m_attachedProperties.find(T::Id());
-        if (iter == m_attachedProperties.cend()) return value;
-        return *(typename T::value_type*)iter->second.get();
+        const typename T::value_type* pvalue = Get<T>();
+        return pvalue != nullptr ? *pvalue : value;
     }
 
     template<typename T> const typename T::value_type* Get() const
     {
-        auto iter = m_attachedProperties.find(T::Id());
-        if (iter == m_attachedProperties.cend()) return nullptr;
-        return (typename T::value_type*)iter->second.get();
+        return const_cast<ObjectWithAttachedProperties*>(this)->template Get<T>();
     }
 
     template<typename T> typename T::value_type* Get()
     {
-        auto iter = m_attachedProperties.find(T::Id());
-        if (iter == m_attachedProperties.cend()) return nullptr;
-        return (typename T::value_type*)iter->second.get();
+        AttachedEntry* pentry = Find(T::Id());
+        if (pentry == nullptr) return nullptr;
+        return &static_cast<T*>(pentry->second.get())->value;
     }
 
     template<typename T> bool Has() const
     {
-        auto iter = m_attachedProperties.find(T::Id());
-        return (iter == m_attachedProperties.cend());
+        return Get<T>() != nullptr;
+    }
+
+protected:
+    AttachedEntry* Find(size_t id)
+    {
+        for (AttachedEntry& entry : m_attachedProperties)
+        {
+            if (entry.first == id)
+                return &entry;
+        }
+
+        // free slots are only ever looked for inline
+        if (id == 0)
+            return nullptr;
+
+        for (AttachedEntry& entry : m_moreAttachedProperties)
+        {
+            if (entry.first == id)
+                return &entry;
+        }
+
+        return nullptr;
     }
 };
 
-} // xpf
\ No newline at end of file
+} // xpf
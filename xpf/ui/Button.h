@@ -60,7 +60,7 @@ public:
     {
         m_clippingEnabled = true;
         m_acceptsFocus = true;
-        m_visualsInvalidated = true;
+        InvalidateVisuals();
         m_HorizontalAlignment = HorizontalAlignment::Center;
         m_VerticalAlignment = VerticalAlignment::Center;
     }
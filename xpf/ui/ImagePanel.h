@@ -35,8 +35,8 @@ protected:
     v2_t m_imageSize;
 
 protected:
-    DECLARE_PROPERTY(ImagePanel, std::shared_ptr<ITexture>, Texture, nullptr, Invalidates::Visuals);
-    DECLARE_PROPERTY(ImagePanel, ImageStretch, Stretch, ImageStretch::None, Invalidates::Visuals);
+    DECLARE_PROPERTY(ImagePanel, std::shared_ptr<ITexture>, Texture, nullptr, Invalidates::ParentLayout);
+    DECLARE_PROPERTY(ImagePanel, ImageStretch, Stretch, ImageStretch::None, Invalidates::ParentLayout);
 
 public:
     ImagePanel() : UIElement(UIElementType::ImagePanel)
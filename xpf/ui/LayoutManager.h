@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace xpf {
+
+class UIElement;
+
+// Elements whose layout got invalidated, laid out once per frame before anything draws.
+// Queued elements are processed shallowest first: laying out an ancestor lays out its
+// descendants too, the ones still queued are then found up to date and skipped. An element
+// whose size changed when measured on its own queues its parent, so invalidation climbs only
+// as far as sizes actually change instead of the whole tree being walked.
+// Definitions follow UIElement in UIElement.h.
+class LayoutManager
+{
+protected:
+    typedef std::pair<uint32_t, UIElement*> QueueEntry; // depth in the tree, element
+    static inline std::vector<QueueEntry> s_queue;
+    static inline std::vector<QueueEntry> s_deferred; // queued during an update, for the next frame
+    static inline bool s_isUpdating = false;
+    static inline uint32_t s_currentDepth = 0;
+
+public:
+    LayoutManager() = delete;
+
+    static void Enqueue(UIElement* pElement);
+    static void Dequeue(UIElement* pElement);
+    static void Update();
+
+protected:
+    static uint32_t GetDepth(const UIElement* pElement);
+    static bool IsDeeper(const QueueEntry& a, const QueueEntry& b) { return a.first > b.first; }
+};
+
+} // xpf
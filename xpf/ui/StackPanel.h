@@ -10,6 +10,8 @@ class StackPanel : public ScrollPanelMixIn<Panel>
 protected:
     DECLARE_PROPERTY(StackPanel, xpf::Orientation, Orientation, Orientation::Vertical, Invalidates::ParentLayout);
 
+    std::vector<std::pair<UIElement*, float>> m_starChildren; // scratch for OnMeasure, kept to reuse its storage
+
 public:
     StackPanel() : ScrollPanelMixIn(UIElementType::StackPanel)
     {
@@ -24,128 +26,66 @@ public:
         float y = 0;
         bool isVertical = (m_Orientation == Orientation::Vertical);
 
-        if (isVertical)
-        {
-            float height_stars = 0;
-            float height_pixels = 0;
-            std::unordered_map<UIElement*, float> heights;
+        // auto and fixed children are measured as they come, star children once the
+        // space left over is known; each child gets measured exactly once
+        float stars = 0;
+        float pixels = 0;
+        m_starChildren.clear();
 
-            for (const auto& sp : m_children)
-            {
-                const PanelLength* pheight = sp->Get<Panel_Length>();
-                if (pheight == nullptr || pheight->type == PanelLength::Auto)
-                {
-                    float height = sp->Measure(insideSize).y;
-                    heights[sp.get()] = height;
-                    height_pixels += height;
-                }
-                else if (pheight->type == PanelLength::Star)
-                {
-                    height_stars += pheight->length;
-                }
-                else
-                {
-                    height_pixels += pheight->length;
-                }
-            }
-
-            float height_pixels_removed = (insideSize.y - height_pixels);
-            if (height_pixels_removed < 0)
-                height_pixels_removed = insideSize.y;
-
-            float height_per_star = height_stars > 0 ? height_pixels_removed / height_stars : 0;
-
-            for (const auto& sp : m_children)
+        auto add = [&](UIElement& child, v2_t desiredSize)
+        {
+            if (isVertical)
             {
-                const PanelLength* pheight = sp->Get<Panel_Length>();
-
-                v2_t suggested_size = insideSize;
-                if (pheight == nullptr || pheight->type == PanelLength::Auto)
-                {
-                    suggested_size.y = heights[sp.get()];
-                }
-                else if (pheight->type == PanelLength::Star)
-                {
-                    suggested_size.y = pheight->length * height_per_star;
-                }
-                else
-                {
-                    suggested_size.y = pheight->length;
-                }
-
-                v2_t desiredSize = sp->Measure(suggested_size);
-                switch (sp->GetHorizontalAlignment())
-                {
-                    case HorizontalAlignment::Stretch:
-                        desiredSize.x = insideSize.w;
-                        break;
-                    default:
-                        break;
-                }
+                if (child.GetHorizontalAlignment() == HorizontalAlignment::Stretch)
+                    desiredSize.x = insideSize.w;
                 x = std::max(x, desiredSize.x);
                 y += desiredSize.y;
             }
-        }
-        else // isHorizontal
-        {
-            float width_stars = 0;
-            float width_pixels = 0;
-            std::unordered_map<UIElement*, float> widths;
-
-            for (const auto& spChild : m_children)
+            else
             {
-                const PanelLength* pwidth = spChild->Get<Panel_Length>();
-                if (pwidth == nullptr || pwidth->type == PanelLength::Auto)
-                {
-                    float width = spChild->Measure(insideSize).x;
-                    widths[spChild.get()] = width;
-                    width_pixels += width;
-                }
-                else if (pwidth->type == PanelLength::Star)
-                {
-                    width_stars += pwidth->length;
-                }
-                else
-                {
-                    width_pixels += pwidth->length;
-                }
+                if (child.GetVerticalAlignment() == VerticalAlignment::Stretch)
+                    desiredSize.y = insideSize.h;
+                x += desiredSize.x;
+                y = std::max(y, desiredSize.y);
             }
+        };
 
-            float width_pixels_removed = (insideSize.x - width_pixels);
-            if (width_pixels_removed < 0)
-                width_pixels_removed = insideSize.x;
+        for (const auto& sp : m_children)
+        {
+            const PanelLength* plength = sp->Get<Panel_Length>();
+            if (plength == nullptr || plength->type == PanelLength::Auto)
+            {
+                v2_t desiredSize = sp->Measure(insideSize);
+                pixels += isVertical ? desiredSize.y : desiredSize.x;
+                add(*sp, desiredSize);
+            }
+            else if (plength->type == PanelLength::Star)
+            {
+                stars += plength->length;
+                m_starChildren.emplace_back(sp.get(), plength->length);
+            }
+            else
+            {
+                v2_t suggested_size = insideSize;
+                (isVertical ? suggested_size.y : suggested_size.x) = plength->length;
+                pixels += plength->length;
+                add(*sp, sp->Measure(suggested_size));
+            }
+        }
 
-            float width_per_star = width_stars > 0 ? width_pixels_removed / width_stars : 0;
+        if (!m_starChildren.empty())
+        {
+            const float available = isVertical ? insideSize.y : insideSize.x;
+            float pixels_removed = available - pixels;
+            if (pixels_removed < 0)
+                pixels_removed = available;
 
-            for (const auto& spChild : m_children)
+            const float per_star = stars > 0 ? pixels_removed / stars : 0;
+            for (const auto& [pchild, length] : m_starChildren)
             {
-                const PanelLength* pwidth = spChild->Get<Panel_Length>();
-
                 v2_t suggested_size = insideSize;
-                if (pwidth == nullptr || pwidth->type == PanelLength::Auto)
-                {
-                    suggested_size.x = widths[spChild.get()];
-                }
-                else if (pwidth->type == PanelLength::Star)
-                {
-                    suggested_size.x = pwidth->length * width_per_star;
-                }
-                else
-                {
-                    suggested_size.x = pwidth->length;
-                }
-
-                v2_t desiredSize = spChild->Measure(suggested_size);
-                switch (spChild->GetVerticalAlignment())
-                {
-                    case VerticalAlignment::Stretch:
-                        desiredSize.y = insideSize.h;
-                        break;
-                    default:
-                        break;
-                }
-                x += desiredSize.x;
-                y = std::max(y, desiredSize.y);
+                (isVertical ? suggested_size.y : suggested_size.x) = length * per_star;
+                add(*pchild, pchild->Measure(suggested_size));
             }
         }
 
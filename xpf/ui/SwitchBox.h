@@ -50,6 +50,7 @@ protected:
     float m_height = 0;
     float m_width = 0;
     SwitchBoxState m_state = SwitchBoxState::Default;
+    uint32_t m_fontEpoch = 0; // fonts loaded when the options were measured, see Font::GetEpoch
 
 public:
     SwitchBox() : UIElement(UIElementType::SwitchBox)
@@ -86,6 +87,7 @@ public:
         if (m_FontSizeIsInPixels)
             typeface.renderOptions = FontRenderOptions::SizeInPixels;
 
+        m_fontEpoch = Font::GetEpoch();
         float totalHeight = 0;
         float totalWidth = 0;
         float x = 0;
@@ -208,6 +210,10 @@ public:
 
     virtual void OnDraw(IRenderer& renderer) override
     {
+        // option sizes change when a font loaded in the background replaces the placeholder glyphs
+        if (m_fontEpoch != Font::GetEpoch()) [[unlikely]]
+            InvalidateLayout();
+
         StateManager(renderer);
 
         if (m_selected != m_SelectedItem && !m_selectionAnimation.IsPlaying())
@@ -26,6 +26,7 @@ protected:
     FormattedText m_formattedText;
     rectf_t m_textRect;
     RenderBatch m_renderCommands;
+    uint32_t m_fontEpoch = 0; // fonts loaded when the text was measured, see Font::GetEpoch
 
 public:
     TextBlock(UIElementType type = UIElementType::TextBlock)
@@ -51,6 +52,7 @@ public:
         m_formattedText.SetMaxWidth(m_Width.ValueOr(constraint.x));
         m_formattedText.SetMaxHeight(m_Height.ValueOr(constraint.y));
         m_formattedText.BuildGeometry();
+        m_fontEpoch = Font::GetEpoch();
 
         return m_formattedText.GetBounds().round_up();
     }
@@ -105,6 +107,11 @@ public:
 
     virtual void OnDraw(IRenderer& renderer) override
     {
+        // a font or glyph page loaded in the background replaces the placeholder glyphs,
+        // the measured size and the built batch are laid out again next frame
+        if (m_fontEpoch != Font::GetEpoch()) [[unlikely]]
+            InvalidateLayout();
+
         renderer.EnqueueCommands(m_renderCommands);
     }
 };
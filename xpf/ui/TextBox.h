@@ -24,7 +24,22 @@ protected:
         char32_t ch32;
     };
 
-    std::vector<charinfo> m_chars;
+    // caret stops of one formatted line, its y follows from the line index
+    struct lineinfo
+    {
+        struct stop
+        {
+            float x;
+            char32_t ch32;
+        };
+
+        int32_t firstChar = 0; // cursor position of the line's first character
+        float endX = 0;
+        std::vector<stop> stops;
+    };
+
+    std::vector<lineinfo> m_caretLines;
+    uint32_t m_fontEpoch = 0; // fonts loaded when the caret stops were taken, see Font::GetEpoch
     FormattedText m_formattedText;
     rectf_t m_textRect;
     RenderBatch m_renderCommands;
@@ -95,31 +110,12 @@ public:
 
         m_formattedText.SetText(m_Text.Get());
         m_formattedText.SetFont(typeface);
-        m_formattedText.BuildGeometry();
+        UpdateCaretLinesIfReshaped();
         m_line_height = m_formattedText.GetLineHeight() + m_formattedText.GetAdvanceNewlineY();
 
-        m_chars.clear();
-        float xpos = 0;
-        float ypos = 0;
-        for (const auto& line : m_formattedText.GetLines())
-        {
-            xpos = 0;
-            for (const auto& g : line.glyphs)
-            {
-                m_chars.push_back({{xpos,ypos}, g.ch});
-                xpos += g.advance_x;
-                if (g.ch == '\n')
-                {
-                    m_newline_width = g.advance_x;
-                    ypos += m_line_height;
-                }
-            }
-        }
-        m_chars.push_back({{xpos,ypos}, 0});
-
         if (m_cursor_position < 0)
         {
-            m_cursor_position = m_chars.size() - 1;
+            m_cursor_position = GetEndPosition();
             m_history.push_back({m_Text.Get(), m_cursor_position});
         }
         return m_formattedText.GetBounds();
@@ -143,10 +139,14 @@ public:
         m_renderCommands = r.Build();
     }
 
-    inline bool IsWhitespace(int32_t i) const { auto ch32 = m_chars[i].ch32; return ch32 == '\n' || ch32 == '\t' || ch32 == ' ';}
+    inline bool IsWhitespace(int32_t i) const { auto ch32 = GetChar(i).ch32; return ch32 == '\n' || ch32 == '\t' || ch32 == ' ';}
 
     virtual void OnDraw(IRenderer& renderer) override
     {
+        // fonts loaded in the background change the glyphs, caret stops are taken again on measure
+        if (m_fontEpoch != Font::GetEpoch()) [[unlikely]]
+            InvalidateLayout();
+
 #if TEXTBOX_DEBUG
         {
             float dbgx = m_textRect.right() - 200, dbgy = m_textRect.x; int32_t dbgfs = 10;
@@ -163,18 +163,19 @@ public:
         }
 #endif
 
+        const v2_t cursorPos = GetChar(m_cursor_position.end).pos;
         float mwidth = (m_textRect.w - m_cursor_width);
         if (m_textRect.w >= m_formattedText.GetBounds().x)
         {
             m_xoffset = 0;
         }
-        else if (m_chars[m_cursor_position.end].pos.x > m_xoffset + mwidth)
+        else if (cursorPos.x > m_xoffset + mwidth)
         {
-            m_xoffset = std::min(m_chars[m_cursor_position.end].pos.x - mwidth, m_formattedText.GetBounds().x);
+            m_xoffset = std::min(cursorPos.x - mwidth, m_formattedText.GetBounds().x);
         }
-        else if (m_chars[m_cursor_position.end].pos.x < m_xoffset)
+        else if (cursorPos.x < m_xoffset)
         {
-            m_xoffset = std::max(0.0f, m_chars[m_cursor_position.end].pos.x - m_xoffset);
+            m_xoffset = std::max(0.0f, cursorPos.x - m_xoffset);
         }
 
         if (m_MultiLine)
@@ -184,13 +185,13 @@ public:
             {
                 m_yoffset = 0;
             }
-            else if ((m_chars[m_cursor_position.end].pos.y + m_line_height) > (m_yoffset + mheight))
+            else if ((cursorPos.y + m_line_height) > (m_yoffset + mheight))
             {
-                m_yoffset = std::min(m_chars[m_cursor_position.end].pos.y + m_line_height - mheight, m_formattedText.GetBounds().y - mheight);
+                m_yoffset = std::min(cursorPos.y + m_line_height - mheight, m_formattedText.GetBounds().y - mheight);
             }
-            else if (m_chars[m_cursor_position.end].pos.y < m_yoffset)
+            else if (cursorPos.y < m_yoffset)
             {
-                m_yoffset = std::max(0.0f, m_chars[m_cursor_position.end].pos.y);
+                m_yoffset = std::max(0.0f, cursorPos.y);
             }
 
             if (m_yoffset < m_line_height)
@@ -209,24 +210,25 @@ public:
             int32_t startpos = std::min(m_cursor_position.start, m_cursor_position.end);
             int32_t endpos = std::max(m_cursor_position.start, m_cursor_position.end);
             v2_t pt;
-            for (size_t i = startpos; i <= endpos; i++)
+            for (int32_t i = startpos; i <= endpos; i++)
             {
+                const charinfo info = GetChar(i);
                 if (i == startpos)
-                    pt = m_chars[i].pos;
+                    pt = info.pos;
 
                 if (i == endpos)
                 {
                     rectf_t rect = rectf_t::from_points(
                         pt.x, pt.y,
-                        m_chars[i].pos.x,
-                        m_chars[i].pos.y + m_formattedText.GetLineHeight()).move(m_textRect.left(), m_textRect.top());
+                        info.pos.x,
+                        info.pos.y + m_formattedText.GetLineHeight()).move(m_textRect.left(), m_textRect.top());
                     renderer.DrawRectangle(rect, xpf::Colors::LightYellow);
                 }
-                else if (m_chars[i].ch32 == '\n')
+                else if (info.ch32 == '\n')
                 {
                     rectf_t rect = rectf_t::from_points(
                         pt.x, pt.y,
-                        m_chars[i].pos.x + m_newline_width,
+                        info.pos.x + m_newline_width,
                         pt.y + m_formattedText.GetLineHeight()).move(m_textRect.left(), m_textRect.top());
                     renderer.DrawRectangle(rect, xpf::Colors::LightYellow);
                     startpos = i + 1;
@@ -238,10 +240,10 @@ public:
 
         if (IsInFocus() && m_cursor_position >= -1)
         {
-            if (m_cursor_position.start > m_chars.size() - 1)
-                m_cursor_position.start = m_chars.size() - 1;
-            if (m_cursor_position.end > m_chars.size() - 1)
-                m_cursor_position.end = m_chars.size() - 1;
+            if (m_cursor_position.start > GetEndPosition())
+                m_cursor_position.start = GetEndPosition();
+            if (m_cursor_position.end > GetEndPosition())
+                m_cursor_position.end = GetEndPosition();
             bool forceDrawCursor = ProcessKeyboard(renderer);
             if (!forceDrawCursor)
                 forceDrawCursor = ProcessMouse(renderer);
@@ -258,9 +260,11 @@ public:
                 s_next_time = Time::GetTime() + (s_cursor_on ? 1.0 : 0.3);
             }
 
-            if (s_cursor_on && m_cursor_position.end < m_chars.size())
+            FrameScheduler::RequestFrameAt(s_next_time);
+
+            if (s_cursor_on && m_cursor_position.end <= GetEndPosition())
             {
-                v2_t cursorcoord = m_chars[m_cursor_position.end].pos;
+                v2_t cursorcoord = GetChar(m_cursor_position.end).pos;
                 float xpos = m_textRect.left() + cursorcoord.x + 1;
                 float ypos = m_textRect.top() + cursorcoord.y;
                 renderer.DrawLine(
@@ -290,28 +294,22 @@ public:
 
     int32_t FindCursorPosition(v2_t mousePos) const
     {
-        int32_t newPosition = m_chars.size() - 1;
-        for (int32_t i = 0; i < m_chars.size() - 1; i++)
+        // the first line reaching below the mouse, in it the first character whose middle is right of the mouse
+        const float y = mousePos.y - m_formattedText.GetLineHeight();
+        const size_t line = (y < 0 || m_line_height <= 0) ? 0 : size_t(y / m_line_height) + 1;
+        if (line >= m_caretLines.size())
+            return GetEndPosition();
+
+        const lineinfo& info = m_caretLines[line];
+        for (size_t i = 0; i < info.stops.size(); i++)
         {
-            const v2_t& chpos = m_chars[i].pos;
-            if (mousePos.y < chpos.y + m_formattedText.GetLineHeight())
-            {
-                const auto& nextEntry = m_chars[i + 1];
-                float x = chpos.x + (nextEntry.pos.x - chpos.x) * .5;
-                if (mousePos.x < x)
-                {
-                    newPosition = i;
-                    break;
-                }
-                else if (m_chars[i].ch32 == '\n')
-                {
-                    newPosition = i;
-                    break;
-                }
-            }
+            const float x = info.stops[i].x;
+            const float nextX = (i + 1 < info.stops.size()) ? info.stops[i + 1].x : info.endX;
+            if (mousePos.x < x + (nextX - x) * .5f || info.stops[i].ch32 == '\n')
+                return info.firstChar + int32_t(i);
         }
 
-        return newPosition;
+        return GetEndPosition();
     }
 
     bool ProcessMouse(IRenderer& renderer)
@@ -423,7 +421,7 @@ public:
         }
 
         isws = IsWhitespace(endpos);
-        while (isws == IsWhitespace(endpos) && endpos < m_chars.size() - 1)
+        while (isws == IsWhitespace(endpos) && endpos < GetEndPosition())
         {
             endpos++;
         }
@@ -462,7 +460,7 @@ public:
         if (ctrlDown && s_a.IsKeyPressed()) // CTRL+A - SELECT ALL
         {
             m_cursor_position.start = 0;
-            m_cursor_position.end = m_chars.size() - 1;
+            m_cursor_position.end = GetEndPosition();
         }
         else if (ctrlDown && (c_pressed || x_pressed)) // Ctrl+C - copy to clipboard OR Ctrl+X to cut to clipboard
         {
@@ -470,7 +468,7 @@ public:
             int32_t startpos = std::min(m_cursor_position.start, m_cursor_position.end);
             int32_t endpos = std::max(m_cursor_position.start, m_cursor_position.end);
             for (size_t i = startpos; i < endpos; i++)
-                str.append32(m_chars[i].ch32);
+                str.append32(GetChar(i).ch32);
             
             if (x_pressed)
             {
@@ -536,7 +534,7 @@ public:
 
                 for (int32_t i = m_cursor_position.end; i-- > 0;)
                 {
-                    if (m_chars[i].ch32 == '\n')
+                    if (GetChar(i).ch32 == '\n')
                     {
                         if (shiftDown)
                             newPos.end = i + 1;
@@ -593,12 +591,12 @@ public:
             if (ctrlDown) // LineEnd
             {
                 Selection newPos;
-                newPos.end = m_chars.size() - 1;
+                newPos.end = GetEndPosition();
                 newPos.start = shiftDown ? m_cursor_position.start : newPos.end;
 
-                for (int32_t i = m_cursor_position.end; i < m_chars.size(); i++)
+                for (int32_t i = m_cursor_position.end; i <= GetEndPosition(); i++)
                 {
-                    if (m_chars[i].ch32 == '\n')
+                    if (GetChar(i).ch32 == '\n')
                     {
                         if (shiftDown)
                             newPos.end = i;
@@ -613,11 +611,11 @@ public:
             else if (altDown)
             {
                 Selection newPos;
-                newPos.end = m_chars.size() - 1;
+                newPos.end = GetEndPosition();
                 newPos.start = shiftDown ? m_cursor_position.start : newPos.end;
 
                 bool startingWithWS = IsWhitespace(m_cursor_position.end);
-                for (int32_t i = m_cursor_position.end; i < m_chars.size(); i++)
+                for (int32_t i = m_cursor_position.end; i <= GetEndPosition(); i++)
                 {
                     if (IsWhitespace(i) != startingWithWS)
                     {
@@ -631,7 +629,7 @@ public:
 
                 m_cursor_position = newPos;
             }
-            else if (m_cursor_position.end < m_chars.size() - 1)
+            else if (m_cursor_position.end < GetEndPosition())
             {
                 if (shiftDown)
                     m_cursor_position.end++;
@@ -661,15 +659,15 @@ public:
         else if (s_up.IsKeyPressed()) // UP
         {
             bool lookingForPrevNewline = true;
-            auto endXY = m_chars[m_cursor_position.end].pos;
+            auto endXY = GetChar(m_cursor_position.end).pos;
             int32_t newEndPos = 0;
             for (int32_t i = m_cursor_position.end; i-- > 0;)
             {
-                if (lookingForPrevNewline && m_chars[i].ch32 == '\n')
+                if (lookingForPrevNewline && GetChar(i).ch32 == '\n')
                 {
                     lookingForPrevNewline = false;
                 }
-                else if (!lookingForPrevNewline && m_chars[i].pos.x <= endXY.x)
+                else if (!lookingForPrevNewline && GetChar(i).pos.x <= endXY.x)
                 {
                     newEndPos = i;
                     break;
@@ -684,15 +682,15 @@ public:
         else if (s_down.IsKeyPressed()) // DOWN
         {
             bool lookingForPrevNewline = true;
-            auto endXY = m_chars[m_cursor_position.end].pos;
-            int32_t newEndPos = m_chars.size() - 1;
-            for (int32_t i = m_cursor_position.end; i < m_chars.size() - 1; i++)
+            auto endXY = GetChar(m_cursor_position.end).pos;
+            int32_t newEndPos = GetEndPosition();
+            for (int32_t i = m_cursor_position.end; i < GetEndPosition(); i++)
             {
-                if (lookingForPrevNewline && m_chars[i].ch32 == '\n')
+                if (lookingForPrevNewline && GetChar(i).ch32 == '\n')
                 {
                     lookingForPrevNewline = false;
                 }
-                else if (!lookingForPrevNewline && m_chars[i].pos.x >= endXY.x)
+                else if (!lookingForPrevNewline && GetChar(i).pos.x >= endXY.x)
                 {
                     newEndPos = i;
                     break;
@@ -729,20 +727,29 @@ public:
 
     int32_t ReplaceText(int32_t start, int32_t end, const std::vector<uint32_t>& ch32)
     {
-        int32_t startpos = std::min(start, end);
-        int32_t endpos = std::max(start, end);
-
-        xpf::stringex txt;
-        for (int32_t i = 0; i < startpos; i++)
-            txt.append32(m_chars[i].ch32);
-
-        for (const auto& ch32 : ch32)
-            txt.append32(ch32);
+        const v2_t bounds = m_formattedText.GetBounds();
+        const bool isReshaped = UpdateCaretLinesIfReshaped();
 
-        for (int32_t i = endpos; i < int32_t(m_chars.size()) - 1; i++)
-            txt.append32(m_chars[i].ch32);
+        int32_t startpos = std::clamp(std::min(start, end), 0, GetEndPosition());
+        int32_t endpos = std::clamp(std::max(start, end), 0, GetEndPosition());
+        const size_t firstLine = GetCaretLineIndex(startpos);
+        const size_t lastLine = GetCaretLineIndex(endpos);
+        const size_t offset = GetTextOffset(startpos, firstLine);
+        const size_t length = GetTextOffset(endpos, lastLine) - offset;
 
-        SetText(txt);
+        xpf::stringex txt;
+        for (const uint32_t ch : ch32)
+            txt.append32(ch);
+
+        // only the edited lines get shaped again and get new caret stops; the text property
+        // takes the result as is, a new layout is only needed when the text changed size
+        m_formattedText.ReplaceText(offset, length, txt);
+        UpdateCaretLines(firstLine, lastLine - firstLine + 1);
+        m_Text.SetWithoutInvalidating(m_formattedText.GetText());
+        if (isReshaped || m_formattedText.GetBounds() != bounds)
+            InvalidateParentLayout();
+        else
+            InvalidateVisuals();
 
         m_history.erase(m_history.cbegin() + m_historyPosition + 1, m_history.cend());
 
@@ -753,6 +760,105 @@ public:
 
         return startpos + ch32.size();
     }
+
+    int32_t GetEndPosition() const
+    {
+        if (m_caretLines.empty()) [[unlikely]]
+            return 0;
+
+        const lineinfo& last = m_caretLines.back();
+        return last.firstChar + int32_t(last.stops.size());
+    }
+
+    size_t GetCaretLineIndex(int32_t position) const
+    {
+        const auto iter = std::upper_bound(m_caretLines.cbegin(), m_caretLines.cend(), position,
+            [](int32_t pos, const lineinfo& line) { return pos < line.firstChar; });
+        return iter == m_caretLines.cbegin() ? 0 : size_t(iter - m_caretLines.cbegin()) - 1;
+    }
+
+    // the character at a cursor position, the end of the text has none
+    charinfo GetChar(int32_t position) const
+    {
+        if (m_caretLines.empty()) [[unlikely]]
+            return {};
+
+        const size_t line = GetCaretLineIndex(position);
+        const lineinfo& info = m_caretLines[line];
+        const float y = line * m_line_height;
+        const size_t i = size_t(std::max(position - info.firstChar, 0));
+        if (i >= info.stops.size())
+            return {{info.endX, y}, 0};
+
+        return {{info.stops[i].x, y}, info.stops[i].ch32};
+    }
+
+    // byte offset of a cursor position, the line holding it is decoded up to it since a
+    // malformed byte shows as a U+FFFD that is three bytes long re-encoded but one in the text
+    size_t GetTextOffset(int32_t position, size_t line)
+    {
+        const std::string& text = m_formattedText.GetText();
+        size_t offset = m_formattedText.GetLines()[line].textOffset;
+        for (int32_t i = m_caretLines[line].firstChar; i < position && offset < text.size(); i++)
+            stringex::utf8_to_utf32(text, offset);
+
+        return offset;
+    }
+
+    // takes the caret stops of the formatted lines that replaced oldCount lines starting at first,
+    // later lines keep theirs and only move
+    void UpdateCaretLines(size_t first, size_t oldCount)
+    {
+        const auto& lines = m_formattedText.GetLines();
+        const size_t count = lines.size() + oldCount - m_caretLines.size();
+
+        int32_t firstChar = 0;
+        if (first > 0)
+            firstChar = m_caretLines[first - 1].firstChar + int32_t(m_caretLines[first - 1].stops.size());
+
+        std::vector<lineinfo> caretLines(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            lineinfo& info = caretLines[i];
+            info.firstChar = firstChar;
+
+            float xpos = 0;
+            for (const auto& g : lines[first + i].glyphs)
+            {
+                info.stops.push_back({xpos, g.ch});
+                xpos += g.advance_x;
+                if (g.ch == '\n')
+                    m_newline_width = g.advance_x;
+            }
+
+            info.endX = xpos;
+            firstChar += int32_t(info.stops.size());
+        }
+
+        if (first + oldCount < m_caretLines.size())
+        {
+            const int32_t delta = firstChar - m_caretLines[first + oldCount].firstChar;
+            for (size_t i = first + oldCount; i < m_caretLines.size(); i++)
+                m_caretLines[i].firstChar += delta;
+        }
+
+        m_caretLines.erase(m_caretLines.begin() + first, m_caretLines.begin() + first + oldCount);
+        m_caretLines.insert(m_caretLines.begin() + first, std::make_move_iterator(caretLines.begin()), std::make_move_iterator(caretLines.end()));
+    }
+
+    // a new text or font, or a font that finished loading, shapes the whole text again
+    bool UpdateCaretLinesIfReshaped()
+    {
+        const bool isReshaped = !m_formattedText.IsGeometryBuilt() || m_fontEpoch != Font::GetEpoch();
+        m_formattedText.BuildGeometry();
+        if (isReshaped)
+        {
+            m_fontEpoch = Font::GetEpoch();
+            UpdateCaretLines(0, m_caretLines.size());
+        }
+
+        return isReshaped;
+    }
 };
 
 } // xpf
\ No newline at end of file
@@ -162,12 +162,27 @@ public:
 };
 
 template<typename T>
-void UIProperty<T>::TryGetValueFromThemeEngine() const
+const T& UIProperty<T>::GetFromSource() const
 {
-    if (m_themeId == ThemeEngine::GetCurrentThemeId())
-        return;
+    const uint8_t currentThemeId = uint8_t(ThemeEngine::GetCurrentThemeId());
+    if (!m_hasGetter && m_themeId == currentThemeId) [[likely]]
+        return m_value;
 
-    m_themeId = ThemeEngine::TryGetValue(m_themeId, m_themeName, m_value);
+    Extras& extras = GetExtras();
+    if (!extras.themeName.empty() && m_themeId != currentThemeId)
+    {
+        // types the themes have no values for are not looked up again either
+        ThemeEngine::TryGetValue(ThemeId(m_themeId), extras.themeName, m_value);
+        m_themeId = currentThemeId;
+    }
+
+    if (extras.getter != nullptr)
+    {
+        auto value = extras.getter(m_value);
+        const_cast<UIProperty*>(this)->Set(value);
+    }
+
+    return m_value;
 }
 
 struct ThemedColor
@@ -221,6 +236,7 @@ class ThemedFormattedText
 {
 protected:
     mutable ThemeId m_themeId = ThemeId::NotSet;
+    mutable TypefaceId m_typefaceId = TypefaceId::NotSet;
     mutable FormattedText m_ft;
     std::string_view m_name;
 
@@ -237,7 +253,8 @@ public:
         if (currentThemeId != m_themeId)
         {
             m_themeId = currentThemeId;
-            m_ft.SetFont(ThemeEngine::GetTypeface(m_name));
+            m_typefaceId = Font::GetTypefaceId(ThemeEngine::GetTypeface(m_name));
+            m_ft.SetFont(m_typefaceId);
         }
 
         return m_ft;
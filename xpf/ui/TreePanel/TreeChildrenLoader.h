@@ -0,0 +1,151 @@
+#pragma once
+#include "TreeNode.h"
+#include <xpf/core/FrameScheduler.h>
+#include <xpf/core/Log.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xpf {
+
+// Handed to a TreeParentNode's children provider, which runs on a worker thread. Nodes added
+// here are appended to the parent on the UI thread, as many per frame as the time budget
+// allows; shaping them waits until they get near the viewport.
+// Providers get threads of their own rather than the font workers, they tend to wait on disk
+// or network. At exit every outstanding loader is cancelled before the threads are joined,
+// so providers have to poll IsCancelled for the app to shut down promptly.
+class TreeChildrenLoader
+{
+friend class TreeParentNode;
+
+public:
+    typedef std::function<void(TreeChildrenLoader&)> Provider;
+
+protected:
+    std::atomic<bool> m_isCancelled = false;
+    std::mutex m_mutex;
+    std::vector<std::shared_ptr<TreeNode>> m_loaded; // not appended yet
+    bool m_isComplete = false;
+
+    static constexpr uint32_t c_workerCount = 2; // a slow provider does not hold up every other
+
+    static inline std::mutex s_mutex;
+    static inline std::condition_variable s_workAvailable;
+    static inline std::deque<std::pair<std::shared_ptr<TreeChildrenLoader>, Provider>> s_work;
+    static inline std::vector<std::shared_ptr<TreeChildrenLoader>> s_running;
+    static inline bool s_shutdown = false;
+
+public:
+    // the parent collapsed or went away, or the app is exiting; the provider should return
+    bool IsCancelled() const { return m_isCancelled; }
+
+    // any thread, typically called with chunks of a few hundred nodes
+    void Add(std::vector<std::shared_ptr<TreeNode>>&& nodes)
+    {
+        if (m_isCancelled)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_loaded.empty())
+                m_loaded = std::move(nodes);
+            else
+                m_loaded.insert(m_loaded.end(), std::make_move_iterator(nodes.begin()), std::make_move_iterator(nodes.end()));
+        }
+        FrameScheduler::RequestFrame();
+    }
+
+protected:
+    // runs provider with the loader on a worker, the workers are started on first use
+    static void Run(const std::shared_ptr<TreeChildrenLoader>& spLoader, const Provider& provider)
+    {
+        EnsureStarted();
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            if (s_shutdown)
+                return;
+            s_work.emplace_back(spLoader, provider);
+        }
+        s_workAvailable.notify_one();
+    }
+
+    void Complete()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isComplete = true;
+        }
+        FrameScheduler::RequestFrame();
+    }
+
+    static void EnsureStarted()
+    {
+        // joins the workers before the statics they use go away
+        struct Workers
+        {
+            std::vector<std::thread> threads;
+
+            Workers()
+            {
+                for (uint32_t i = 0; i < c_workerCount; i++)
+                    threads.emplace_back(&TreeChildrenLoader::RunWorker);
+            }
+
+            ~Workers()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(s_mutex);
+                    s_shutdown = true;
+                    s_work.clear();
+                    for (const auto& spLoader : s_running)
+                        spLoader->m_isCancelled = true;
+                }
+                s_workAvailable.notify_all();
+                for (auto& thread : threads)
+                    thread.join();
+            }
+        };
+
+        static Workers s_workers;
+    }
+
+    static void RunWorker()
+    {
+        for (;;)
+        {
+            std::pair<std::shared_ptr<TreeChildrenLoader>, Provider> work;
+            {
+                std::unique_lock<std::mutex> lock(s_mutex);
+                s_workAvailable.wait(lock, []() { return s_shutdown || !s_work.empty(); });
+                if (s_shutdown)
+                    return;
+
+                work = std::move(s_work.front());
+                s_work.pop_front();
+                s_running.push_back(work.first);
+            }
+
+            TreeChildrenLoader& loader = *work.first;
+            if (!loader.IsCancelled())
+            {
+                try {
+                    work.second(loader);
+                } catch (const std::exception& e) {
+                    Log::error(std::string("TreeChildrenLoader: ") + e.what());
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(s_mutex);
+                std::erase(s_running, work.first);
+            }
+            loader.Complete();
+        }
+    }
+};
+
+} // xpf
@@ -2,6 +2,8 @@
 #include <xpf/ui/TreePanel/TreeNode.h>
 #include <xpf/ui/TreePanel/TreeParentNode.h>
 #include <xpf/ui/TreePanel/TreeLeafNode.h>
+#include <algorithm>
+#include <functional>
 #include <vector>
 #include <memory>
 
@@ -10,20 +12,33 @@ namespace xpf {
 class TreeData
 {
 protected:
-    std::vector<std::shared_ptr<TreeNode>> m_nodes;
-    std::vector<TreeNode*> m_visible_nodes;
-    v2_t m_bounds;
+    TreeNodeList m_nodes{nullptr};
+
+    // nodes are only shaped once they get near the viewport, until then they are assumed to be
+    // as high as the nodes measured so far on average
+    float m_estimatedHeight = c_defaultNodeHeight;
+    double m_measuredHeight = 0;
+    size_t m_measuredCount = 0;
+    float m_width = -1;
+    float m_maxWidth = 0;
     float m_height_multiplier = 1.2;
     float m_indent = 20;
 
+    static constexpr float c_defaultNodeHeight = 20;
+
 public:
-    void SetHeightMultiplier(float value) { m_height_multiplier = value; }
+    void SetHeightMultiplier(float value) { m_height_multiplier = value; m_width = -1; }
 
     void AddNode(std::shared_ptr<TreeNode>&& node)
     {
-        m_nodes.push_back(std::move(node));
-        m_visible_nodes.clear();
-        m_bounds = v2_t();
+        node->m_pParent = nullptr;
+        m_nodes.Append(node);
+    }
+
+    void InsertNode(size_t index, const std::shared_ptr<TreeNode>& spNode)
+    {
+        spNode->m_pParent = nullptr;
+        m_nodes.Insert(index, spNode);
     }
 
     bool DeleteNode(TreeNode* pNode)
@@ -32,42 +47,177 @@ public:
         if (pParent != nullptr)
             return pParent->RemoveNode(pNode);
 
-        for (auto iter = m_nodes.begin(); iter != m_nodes.end(); iter++)
+        return m_nodes.Remove(pNode);
+    }
+
+    const std::vector<std::shared_ptr<TreeNode>>& GetNodes() const { return m_nodes.GetNodes(); }
+
+    bool IsVisible(const TreeNode* pNode) const
+    {
+        for (const TreeNodeList* pList = pNode->m_pList; pList != nullptr; pList = pList->m_pOwner->m_pList)
         {
-            if (iter->get() == pNode)
-            {
-                m_nodes.erase(iter);
+            if (pList == &m_nodes)
                 return true;
-            }
+
+            if (pList->m_pOwner == nullptr || !pList->m_pOwner->GetIsExpanded())
+                return false;
         }
 
         return false;
     }
 
-    const std::vector<TreeNode*>& GetVisibleNodes() const { return m_visible_nodes; }
-    const std::vector<std::shared_ptr<TreeNode>>& GetNodes() const { return m_nodes; }
+    float GetNodeHeight(const TreeNode* pNode) const { return pNode->m_hasHeight ? pNode->m_height : m_estimatedHeight; }
 
-    v2_t Measure(float width)
+    // top of a visible node in the content, O(depth * log n)
+    float GetNodeOffset(TreeNode* pNode)
+    {
+        double offset = 0;
+        for (TreeNodeList* pList = pNode->m_pList; pList != nullptr; pList = pNode->m_pList)
+        {
+            offset += pList->GetOffset(pNode->m_indexInList, m_estimatedHeight);
+            pNode = pList->m_pOwner;
+            if (pNode == nullptr)
+                break;
+
+            offset += GetNodeHeight(pNode);
+        }
+
+        return float(offset);
+    }
+
+    // the visible node at the given offset into the content, descending the tree level by level
+    TreeNode* FindNodeAt(float offset)
+    {
+        if (m_nodes.empty())
+            return nullptr;
+
+        double top = 0;
+        for (TreeNodeList* pList = &m_nodes;;)
+        {
+            TreeNode* pNode = (*pList)[pList->FindAt(offset - top, m_estimatedHeight)];
+            top += pList->GetOffset(pNode->m_indexInList, m_estimatedHeight) + GetNodeHeight(pNode);
+
+            TreeNodeList* pChildren = pNode->GetChildren();
+            if (offset < top || pChildren == nullptr || pChildren->empty() || !pNode->GetIsExpanded())
+                return pNode;
+
+            pList = pChildren;
+        }
+    }
+
+    TreeNode* GetFirstVisibleNode() const { return m_nodes.empty() ? nullptr : m_nodes.front(); }
+
+    TreeNode* GetNextVisibleNode(TreeNode* pNode) const
+    {
+        TreeNodeList* pChildren = pNode->GetChildren();
+        if (pChildren != nullptr && !pChildren->empty() && pNode->GetIsExpanded())
+            return pChildren->front();
+
+        for (TreeNodeList* pList = pNode->m_pList; pList != nullptr; pList = pNode->m_pList)
+        {
+            if (pNode->m_indexInList + 1 < pList->size())
+                return (*pList)[pNode->m_indexInList + 1];
+
+            pNode = pList->m_pOwner;
+            if (pNode == nullptr)
+                break;
+        }
+
+        return nullptr;
+    }
+
+    TreeNode* GetPreviousVisibleNode(TreeNode* pNode) const
     {
-        m_visible_nodes.clear();
+        TreeNodeList* pList = pNode->m_pList;
+        if (pList == nullptr)
+            return nullptr;
 
-        m_bounds = v2_t();
-        for (const auto& spNode : m_nodes)
+        if (pNode->m_indexInList == 0)
+            return pList->m_pOwner;
+
+        // the last visible descendant of the sibling before
+        pNode = (*pList)[pNode->m_indexInList - 1];
+        for (TreeNodeList* pChildren = pNode->GetChildren();
+            pChildren != nullptr && !pChildren->empty() && pNode->GetIsExpanded();
+            pChildren = pNode->GetChildren())
         {
-            v2_t size = spNode->Measure(width, /*depth:*/ 0, m_height_multiplier, m_visible_nodes);
-            if (size.x > m_bounds.x)
-                m_bounds.x = size.x;
+            pNode = pChildren->back();
+        }
+
+        return pNode;
+    }
 
-            m_bounds.y += size.y;
+    void ForEachVisibleNode(const std::function<void(TreeNode*)>& fn) const
+    {
+        for (TreeNode* pNode = GetFirstVisibleNode(); pNode != nullptr; pNode = GetNextVisibleNode(pNode))
+            fn(pNode);
+    }
+
+    // content size, widths and heights of nodes not measured yet are estimates
+    v2_t GetBounds() const { return v2_t(m_maxWidth, float(m_nodes.GetHeight(m_estimatedHeight))); }
+
+    // heights are kept up to date as nodes change, nothing gets visited or shaped here
+    v2_t Measure(float width)
+    {
+        if (width != m_width)
+        {
+            m_width = width;
+            m_maxWidth = 0;
         }
 
-        return m_bounds;
+        if (m_measuredCount > 0)
+            m_estimatedHeight = xpf::math::round_up(float(m_measuredHeight / m_measuredCount));
+
+        return GetBounds();
     }
 
-    void UpdateVisuals(IRenderer& renderer)
+    // shapes a visible node if it was not for the current width yet; true if its height changed
+    bool MeasureNode(TreeNode* pNode)
     {
-        for (const auto& spNode : m_nodes)
-            spNode->UpdateVisuals(renderer);
+        // nodes may have moved since they were last measured
+        int32_t depth = 0;
+        for (TreeNodeList* pList = pNode->m_pList; pList != nullptr && pList->m_pOwner != nullptr; pList = pList->m_pOwner->m_pList)
+            depth++;
+
+        if (depth != pNode->m_depth)
+        {
+            pNode->m_depth = depth;
+            pNode->m_indent = depth * TreeNode::m_indentWidth;
+            pNode->m_measuredWidth = -1;
+        }
+
+        if (pNode->m_measuredWidth == m_width)
+            return false;
+
+        const float oldHeight = pNode->m_height;
+        const bool hadHeight = pNode->m_hasHeight;
+        const v2_t bounds = pNode->Measure(m_width, m_height_multiplier);
+        pNode->m_measuredWidth = m_width;
+        pNode->m_hasHeight = true;
+        m_maxWidth = std::max(m_maxWidth, bounds.x);
+
+        // the average counts every node once, a node measured again replaces its height
+        if (hadHeight)
+        {
+            m_measuredHeight += bounds.y - oldHeight;
+        }
+        else
+        {
+            m_measuredHeight += bounds.y;
+            m_measuredCount++;
+        }
+
+        if (!hadHeight)
+        {
+            pNode->OnSubtreeChanged(bounds.y, -1);
+            return bounds.y != m_estimatedHeight;
+        }
+
+        if (bounds.y == oldHeight)
+            return false;
+
+        pNode->OnSubtreeChanged(bounds.y - oldHeight, 0);
+        return true;
     }
 };
 
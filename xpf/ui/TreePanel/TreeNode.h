@@ -3,7 +3,10 @@
 #include <xpf/renderer/common/Font.h>
 #include <xpf/renderer/common/RenderBatchBuilder.h>
 
+#include <algorithm>
+#include <bit>
 #include <memory>
+#include <vector>
 #include <xpf/core/stringex.h>
 #include <xpf/core/Color.h>
 #include <xpf/core/Rectangle.h>
@@ -21,12 +24,14 @@ enum class TreeNodeType
 };
 
 class TreeData;
+class TreeNodeList;
 class TreePanel;
 class TreeParentNode;
 
 class TreeNode
 {
 friend TreeData;
+friend TreeNodeList;
 friend TreePanel;
 friend TreeParentNode;
 
@@ -37,9 +42,18 @@ protected:
     int32_t m_depth = 0;
     float m_iconWidth = 0;
     float m_height = 0;
+    float m_measuredWidth = -1; // width the text was shaped for, negative when it has to be shaped again
+    bool m_hasHeight = false;   // m_height was measured once, it stays a good guess after text changes
     float m_indent = 0;
     std::shared_ptr<UIElement> m_spIcon;
     TreeParentNode* m_pParent = nullptr;
+    TreeNodeList* m_pList = nullptr; // the parent's children or TreeData's top level nodes
+    size_t m_indexInList = 0;
+
+    // what the node and its visible descendants add up to, nodes not measured yet are
+    // counted separately as TreeData's estimated height can still change
+    double m_subtreeHeight = 0;
+    size_t m_subtreeUnmeasured = 1;
 
 protected:
     TreeNodeType m_type = TreeNodeType::Leaf;
@@ -58,18 +72,19 @@ public:
     virtual ~TreeNode() = default;
 
     TreeNodeType GetType() const { return m_type; }
-    void SetText(std::string_view value) { m_ft.SetText(value); }
+    void SetText(std::string_view value) { m_ft.SetText(value); m_measuredWidth = -1; }
     const std::string& GetText() const { return m_ft.GetText(); }
 
-    void SetIcon(const std::shared_ptr<UIElement>& sp) { m_spIcon = sp; }
+    void SetIcon(const std::shared_ptr<UIElement>& sp) { m_spIcon = sp; m_measuredWidth = -1; }
 
-    void SetThemeId(std::string_view themeId) { m_ft.SetThemeId(themeId); }
+    void SetThemeId(std::string_view themeId) { m_ft.SetThemeId(themeId); m_measuredWidth = -1; }
 
     virtual void SetIsExpanded(bool value) {}
     virtual bool GetIsExpanded() const { return true; }
     virtual bool ToggleIsExpanded() { return false; };
 
-    virtual v2_t Measure(float width, int32_t depth, float heightMultiplier, std::vector<TreeNode*>& visibleNodes)
+    // shapes this node's own line, done by TreeData once the node gets near the viewport
+    virtual v2_t Measure(float width, float heightMultiplier)
     {
         m_iconWidth = 0;
         if (m_spIcon != nullptr)
@@ -77,10 +92,6 @@ public:
 
         width -= m_iconWidth;
 
-        m_depth = depth;
-        m_indent = m_depth * m_indentWidth;
-        visibleNodes.push_back(this);
-
         m_ft.Get().SetMaxWidth(width - m_indent);
         m_ft.Get().BuildGeometry();
         v2_t bounds = m_ft.Get().GetBounds();
@@ -125,6 +136,200 @@ public:
     {
         return (m_y < pos.y && pos.y < m_y + m_height);
     }
+
+protected:
+    virtual TreeNodeList* GetChildren() { return nullptr; }
+
+    // the node's own line or its visible descendants changed height, the lists above it follow
+    void OnSubtreeChanged(double height, ptrdiff_t unmeasured);
 };
 
+// The children of a TreeParentNode or the top level nodes of a TreeData. Keeps Fenwick trees
+// over the heights of the nodes' visible subtrees so that the offset of a node, and the node
+// at an offset, are found in O(log n), and a node changing height costs O(log n) per level
+// above it instead of the visible nodes being laid out again.
+//
+// The trees cover a prefix of the nodes. Adding or removing a node renumbers the siblings
+// after it and drops their entries, the next query adds them back at O(log n) each; appending
+// (or inserting just before the last node, as loading children does) stays O(log n).
+class TreeNodeList
+{
+friend TreeNode;
+friend TreeData;
+
+protected:
+    TreeNode* m_pOwner = nullptr; // null for the top level
+    std::vector<std::shared_ptr<TreeNode>> m_nodes;
+
+    // 1 based, cover the first size() - 1 nodes, the rest are added on the next query
+    std::vector<double> m_heightTree = {0};
+    std::vector<size_t> m_unmeasuredTree = {0};
+
+    double m_measuredHeight = 0;
+    size_t m_unmeasuredCount = 0;
+
+public:
+    TreeNodeList(TreeNode* pOwner) : m_pOwner(pOwner) {}
+    TreeNodeList(const TreeNodeList&) = delete;
+    TreeNodeList& operator=(const TreeNodeList&) = delete;
+
+    const std::vector<std::shared_ptr<TreeNode>>& GetNodes() const { return m_nodes; }
+    size_t size() const { return m_nodes.size(); }
+    bool empty() const { return m_nodes.empty(); }
+    TreeNode* front() const { return m_nodes.front().get(); }
+    TreeNode* back() const { return m_nodes.back().get(); }
+    TreeNode* operator[](size_t index) const { return m_nodes[index].get(); }
+
+    // height of all the nodes in the list and their visible descendants
+    double GetHeight(float estimatedHeight) const { return m_measuredHeight + m_unmeasuredCount * double(estimatedHeight); }
+    double GetMeasuredHeight() const { return m_measuredHeight; }
+    size_t GetUnmeasuredCount() const { return m_unmeasuredCount; }
+
+    void Insert(size_t index, const std::shared_ptr<TreeNode>& spNode)
+    {
+        index = std::min(index, m_nodes.size());
+        m_nodes.insert(m_nodes.begin() + index, spNode);
+        spNode->m_pList = this;
+        for (size_t i = index; i < m_nodes.size(); i++)
+            m_nodes[i]->m_indexInList = i;
+
+        TruncateTrees(index);
+        Propagate(index, spNode->m_subtreeHeight, ptrdiff_t(spNode->m_subtreeUnmeasured));
+    }
+
+    void Append(const std::shared_ptr<TreeNode>& spNode) { Insert(m_nodes.size(), spNode); }
+
+    bool Remove(TreeNode* pNode)
+    {
+        const size_t index = pNode->m_indexInList;
+        if (pNode->m_pList != this || index >= m_nodes.size() || m_nodes[index].get() != pNode)
+            return false;
+
+        const double height = pNode->m_subtreeHeight;
+        const ptrdiff_t unmeasured = ptrdiff_t(pNode->m_subtreeUnmeasured);
+        pNode->m_pList = nullptr;
+        m_nodes.erase(m_nodes.begin() + index);
+        for (size_t i = index; i < m_nodes.size(); i++)
+            m_nodes[i]->m_indexInList = i;
+
+        TruncateTrees(index);
+        Propagate(index, -height, -unmeasured);
+        return true;
+    }
+
+    void Clear()
+    {
+        for (const auto& spNode : m_nodes)
+            spNode->m_pList = nullptr;
+
+        m_nodes.clear();
+        TruncateTrees(0);
+        Propagate(0, -m_measuredHeight, -ptrdiff_t(m_unmeasuredCount));
+    }
+
+    // top of the node at the index, relative to the top of the list
+    double GetOffset(size_t index, float estimatedHeight)
+    {
+        UpdateTrees();
+        double height = 0;
+        size_t unmeasured = 0;
+        for (size_t i = index; i > 0; i -= i & (~i + 1))
+        {
+            height += m_heightTree[i];
+            unmeasured += m_unmeasuredTree[i];
+        }
+
+        return height + unmeasured * double(estimatedHeight);
+    }
+
+    // index of the node whose visible subtree covers the offset, relative to the top of the
+    // list, the last node when the offset is below all of them
+    size_t FindAt(double offset, float estimatedHeight)
+    {
+        UpdateTrees();
+        size_t index = 0;
+        double height = 0;
+        size_t unmeasured = 0;
+        for (size_t step = std::bit_floor(m_nodes.size()); step > 0; step >>= 1)
+        {
+            const size_t next = index + step;
+            if (next > m_nodes.size())
+                continue;
+
+            if (height + m_heightTree[next] + (unmeasured + m_unmeasuredTree[next]) * double(estimatedHeight) <= offset)
+            {
+                index = next;
+                height += m_heightTree[next];
+                unmeasured += m_unmeasuredTree[next];
+            }
+        }
+
+        return std::min(index, m_nodes.size() - 1);
+    }
+
+protected:
+    // the node at the index changed by the given amounts, so do the lists above for as long
+    // as the nodes owning them are expanded
+    void Propagate(size_t index, double height, ptrdiff_t unmeasured)
+    {
+        for (TreeNodeList* pList = this; pList != nullptr;)
+        {
+            pList->m_measuredHeight += height;
+            pList->m_unmeasuredCount += unmeasured;
+            for (size_t i = index + 1; i < pList->m_heightTree.size(); i += i & (~i + 1))
+            {
+                pList->m_heightTree[i] += height;
+                pList->m_unmeasuredTree[i] += unmeasured;
+            }
+
+            TreeNode* pOwner = pList->m_pOwner;
+            if (pOwner == nullptr || !pOwner->GetIsExpanded())
+                break;
+
+            pOwner->m_subtreeHeight += height;
+            pOwner->m_subtreeUnmeasured += unmeasured;
+            index = pOwner->m_indexInList;
+            pList = pOwner->m_pList;
+        }
+    }
+
+    // entries of the nodes from the index on go, they get added back by UpdateTrees
+    void TruncateTrees(size_t index)
+    {
+        if (index + 1 < m_heightTree.size())
+        {
+            m_heightTree.resize(index + 1);
+            m_unmeasuredTree.resize(index + 1);
+        }
+    }
+
+    void UpdateTrees()
+    {
+        for (size_t i = m_heightTree.size(); i <= m_nodes.size(); i++)
+        {
+            // entry i sums the nodes (i - lowbit(i), i], the ones before i are covered already
+            // and the entries j = i - 1, j - lowbit(j), ... split that range between them
+            double height = m_nodes[i - 1]->m_subtreeHeight;
+            size_t unmeasured = m_nodes[i - 1]->m_subtreeUnmeasured;
+            const size_t first = i - (i & (~i + 1));
+            for (size_t j = i - 1; j > first; j -= j & (~j + 1))
+            {
+                height += m_heightTree[j];
+                unmeasured += m_unmeasuredTree[j];
+            }
+
+            m_heightTree.push_back(height);
+            m_unmeasuredTree.push_back(unmeasured);
+        }
+    }
+};
+
+inline void TreeNode::OnSubtreeChanged(double height, ptrdiff_t unmeasured)
+{
+    m_subtreeHeight += height;
+    m_subtreeUnmeasured += unmeasured;
+    if (m_pList != nullptr)
+        m_pList->Propagate(m_indexInList, height, unmeasured);
+}
+
 } // xpf
@@ -39,6 +39,7 @@ protected:
     TreeNode* m_itemToolbarOnNode = nullptr;
     rectf_t m_deleteItemButtonRect;
     rectf_t m_moveItemButtonRect;
+    TextDescription m_itemButtonIcon; // kept so its typeface id is resolved once
 
     struct TreePanelInteractiveNode
     {
@@ -59,6 +60,8 @@ protected:
     std::unordered_map<TreeNode*, TreePanelInteractiveNode> m_animatingNodes;
     xpf::Color m_shadowColor = xpf::Colors::Black.with_alpha(64);
 
+    static constexpr seconds_t c_appendChildrenBudget = .004; // per frame, for children loaded in the background
+
 public:
     TreePanel() : ScrollPanelMixIn<UIElement>(UIElementType::TreePanel)
     {
@@ -67,6 +70,12 @@ public:
         m_clippingEnabled = true;
         m_HorizontalScrollbarEnabled = false;
         m_itemToolbarExpandAnimation.From(0);
+
+        m_itemButtonIcon.foreground = xpf::Colors::White;
+        m_itemButtonIcon.fontName = "segoeicons";
+        m_itemButtonIcon.fontSize = 14;
+        m_itemButtonIcon.trimming = TextTrimming::None;
+        m_itemButtonIcon.renderOptions = FontRenderOptions::SizeInPixels;
     }
 
     void SetData(const std::shared_ptr<TreeData>& sp) { m_spData = sp; InvalidateLayout(); }
@@ -92,50 +101,42 @@ public:
 
     virtual void OnArrange(v2_t size) override
     {
-        float y = m_insideRect.top() - m_VerticalScrollPosition;
         m_drawnNodes.clear();
         m_minDrawnDepth = m_maxDrawnDepth = -1;
-        bool addNextOneForLast = false;
 
-        TreeNode* pPrevNode = nullptr;
-        for (TreeNode* pNode : m_spData->GetVisibleNodes())
+        // from the node above the viewport to the second one below it
+        TreeNode* pNode = m_spData->FindNodeAt(m_VerticalScrollPosition);
+        if (pNode != nullptr && m_spData->GetPreviousVisibleNode(pNode) != nullptr)
+            pNode = m_spData->GetPreviousVisibleNode(pNode);
+
+        float y = 0;
+        for (size_t beyond = 0; pNode != nullptr; pNode = m_spData->GetNextVisibleNode(pNode))
         {
+            // nodes get shaped as they come into view, replacing their estimated height,
+            // which only moves the nodes below them
+            m_spData->MeasureNode(pNode);
+            if (m_drawnNodes.empty())
+                y = m_insideRect.top() - m_VerticalScrollPosition + m_spData->GetNodeOffset(pNode);
+
             pNode->m_y = y;
-            float height = pNode->m_height;
+            y += pNode->m_height;
             m_minDrawnDepth = std::min(m_minDrawnDepth, pNode->m_depth);
             m_maxDrawnDepth = std::max(m_maxDrawnDepth, pNode->m_depth);
-            if (addNextOneForLast)
-            {
-                m_drawnNodes.push_back(pNode);
-                break;
-            }
-            else if (y + height < m_insideRect.top())
-            {
-                // noop - skipping
-            }
-            else if (y > m_insideRect.bottom())
-            {
-                m_drawnNodes.push_back(pNode);
-                addNextOneForLast = true;
-            }
-            else
-            {
-                if (m_drawnNodes.empty() && pPrevNode != nullptr)
-                    m_drawnNodes.push_back(pPrevNode);
+            m_drawnNodes.push_back(pNode);
 
-                m_drawnNodes.push_back(pNode);
-            }
-            pPrevNode = pNode;
-            y += height;
+            if (pNode->m_y > m_insideRect.bottom() && ++beyond == 2)
+                break;
         }
 
+        m_ContentSize.Set(m_spData->GetBounds());
+
         m_ViewPortSize.Set(m_insideRect.size());
         ArrangeScrollbars(m_insideRect);
     }
 
     virtual void OnUpdateVisuals(IRenderer& renderer) override
     {
-        for (const auto& pNode : m_spData->GetVisibleNodes())
+        for (TreeNode* pNode : m_drawnNodes)
             pNode->UpdateVisuals(renderer);
 
         ScrollPanelMixIn::OnUpdateVisuals(renderer);
@@ -143,6 +144,8 @@ public:
 
     virtual void OnDraw(IRenderer& renderer) override
     {
+        AppendLoadedChildren();
+
         v2_t mousePos = GetMousePosition(renderer);
 
         DrawNodes(renderer, mousePos);
@@ -246,7 +249,7 @@ protected:
     void DrawNodes(IRenderer& renderer, v2_t mousePos)
     {
         const bool isMouseInside = IsMouseInside();
-        float y = m_insideRect.y - m_VerticalScrollPosition;
+        float y = m_drawnNodes.empty() ? 0 : m_drawnNodes.front()->m_y;
         const bool needToDrawInsertPoint = m_pNode_Dragging != nullptr;
         m_dragDropData.pParent = nullptr;
         m_dragDropData.pAfterChildNode = nullptr;
@@ -282,7 +285,7 @@ protected:
         {
             if (mousePos.y > m_insideRect.top())
             {
-                for (TreeNode* pNode : m_spData->GetVisibleNodes())
+                m_spData->ForEachVisibleNode([&](TreeNode* pNode)
                 {
                     if (pNode->GetType() == TreeNodeType::Parent)
                     {
@@ -295,7 +298,7 @@ protected:
                         else
                             m_dragDropData.pParent = nullptr;
                     }
-                }
+                });
             }
 
         }
@@ -436,12 +439,7 @@ protected:
 
     void DrawMoveButton(IRenderer& renderer, float x, float y, float width, float height, v2_t mousePos)
     {
-        TextDescription desc;
-        desc.foreground = xpf::Colors::White;
-        desc.fontName = "segoeicons";
-        desc.fontSize = 14;
-        desc.trimming = TextTrimming::None;
-        desc.renderOptions = FontRenderOptions::SizeInPixels;
+        const TextDescription& desc = m_itemButtonIcon;
 
         // delete button
         m_moveItemButtonRect = rectf_t{x, y, width, height};
@@ -459,12 +457,7 @@ protected:
 
     void DrawDeleteButton(IRenderer& renderer, float x, float y, float width, float height, v2_t mousePos)
     {
-        TextDescription desc;
-        desc.foreground = xpf::Colors::White;
-        desc.fontName = "segoeicons";
-        desc.fontSize = 14;
-        desc.trimming = TextTrimming::None;
-        desc.renderOptions = FontRenderOptions::SizeInPixels;
+        const TextDescription& desc = m_itemButtonIcon;
 
         // delete button
         m_deleteItemButtonRect = rectf_t{x, y, width, height};
@@ -537,11 +530,8 @@ protected:
 
         if (m_pSelectedNode == nullptr)
         {
-            for (TreeNode* pNode : m_spData->GetVisibleNodes())
-            {
+            if (TreeNode* pNode = m_spData->GetFirstVisibleNode())
                 NodeSelected(pNode);
-                return;
-            }
         }
     }
 
@@ -574,62 +564,67 @@ protected:
 
     TreeNode* PrevNode(TreeNode* pStart)
     {
-        TreeNode* pPrevNode = nullptr;
-        for (TreeNode* pNode : m_spData->GetVisibleNodes())
-        {
-            if (pNode == pStart && pPrevNode != nullptr)
-                return pPrevNode;
-
-            pPrevNode = pNode;
-        }
-
-        return pStart;
+        TreeNode* pNode = m_spData->IsVisible(pStart) ? m_spData->GetPreviousVisibleNode(pStart) : nullptr;
+        return pNode != nullptr ? pNode : pStart;
     }
 
     TreeNode* NextNode(TreeNode* pStart)
     {
-        bool selectNextOne = false;
-        for (TreeNode* pNode : m_spData->GetVisibleNodes())
-        {
-            if (selectNextOne)
-                return pNode;
-            else if (pNode == pStart)
-                selectNextOne = true;
-        }
-
-        return pStart;
+        TreeNode* pNode = m_spData->IsVisible(pStart) ? m_spData->GetNextVisibleNode(pStart) : nullptr;
+        return pNode != nullptr ? pNode : pStart;
     }
 
     void NodesBetween(TreeNode* pStart, TreeNode* pEnd, std::function<void(TreeNode*)>&& fn)
     {
-        if (pStart->m_y > pEnd->m_y)
+        if (!m_spData->IsVisible(pStart) || !m_spData->IsVisible(pEnd))
+            return;
+
+        if (m_spData->GetNodeOffset(pStart) > m_spData->GetNodeOffset(pEnd))
             std::swap(pStart, pEnd);
 
-        bool startFound = false;
-        for (TreeNode* pNode : m_drawnNodes)
+        for (TreeNode* pNode = pStart; pNode != nullptr; pNode = m_spData->GetNextVisibleNode(pNode))
         {
-            if (startFound)
-            {
-                fn(pNode);
-                if (pNode == pEnd)
-                    return;
-            }
-            else if (pNode == pStart)
-            {
-                startFound = true;
-                fn(pNode);
-                if (pNode == pEnd)
-                    return;
-            }
+            fn(pNode);
+            if (pNode == pEnd)
+                break;
         }
     }
 
-    void VerticalScrollToNode(const TreeNode* pNode)
+    // children loaded on workers for expanded nodes of this tree get appended within the
+    // frame's budget, what does not fit waits for the next frame
+    void AppendLoadedChildren()
     {
-        if (pNode->m_y < 0)
-            VerticalScrollTo(pNode->m_y + m_VerticalScrollPosition.Get());
-        else if (pNode->m_y + pNode->m_height > m_ViewPortSize.Get().h)
-            VerticalScrollTo(pNode->m_y + pNode->m_height - m_ViewPortSize.Get().h + m_VerticalScrollPosition.Get());
+        const std::vector<TreeParentNode*>& loadingNodes = TreeParentNode::GetLoadingNodes();
+        if (loadingNodes.empty()) [[likely]]
+            return;
+
+        const time_t deadline = Time::GetRealTime() + c_appendChildrenBudget;
+        bool appended = false;
+
+        // a node done loading takes itself off the list, so back to front
+        for (size_t i = loadingNodes.size(); i > 0; i--)
+        {
+            TreeParentNode* pNode = loadingNodes[i - 1];
+            if (m_spData->IsVisible(pNode) && pNode->GetIsExpanded())
+                appended |= pNode->AppendLoadedChildren(deadline);
+        }
+
+        if (appended)
+            InvalidateLayout();
+    }
+
+    void VerticalScrollToNode(TreeNode* pNode)
+    {
+        if (!m_spData->IsVisible(pNode))
+            return;
+
+        // m_y is only kept up to date for drawn nodes
+        m_spData->MeasureNode(pNode);
+        const float y = m_insideRect.top() - m_VerticalScrollPosition + m_spData->GetNodeOffset(pNode);
+        if (y < 0)
+            VerticalScrollTo(y + m_VerticalScrollPosition.Get());
+        else if (y + pNode->m_height > m_ViewPortSize.Get().h)
+            VerticalScrollTo(y + pNode->m_height - m_ViewPortSize.Get().h + m_VerticalScrollPosition.Get());
     }
 
     void StateManager(IRenderer& renderer, v2_t mousePos)
@@ -1,33 +1,96 @@
 #pragma once
 #include "TreeNode.h"
+#include "TreeLeafNode.h"
+#include "TreeChildrenLoader.h"
+#include <xpf/core/FrameScheduler.h>
+#include <xpf/core/Time.h>
 #include <xpf/ui/UIElement.h>
+#include <mutex>
 
 namespace xpf {
 
 class TreeParentNode : public TreeNode
 {
 protected:
-    std::vector<std::shared_ptr<TreeNode>> m_nodes;
+    TreeNodeList m_nodes{this};
     std::shared_ptr<UIElement> m_spExpandedIcon;
     std::function<void(TreeParentNode&, bool collapsing)> m_onExpandingOrCollapsing;
     bool m_isExpanded = true;
 
+    // children produced off the UI thread
+    TreeChildrenLoader::Provider m_childrenProvider;
+    std::shared_ptr<TreeChildrenLoader> m_spLoader; // while loading
+    std::shared_ptr<TreeNode> m_spLoadingNode;      // shown below the children loaded so far
+    std::vector<std::shared_ptr<TreeNode>> m_appending;
+    size_t m_appended = 0;
+    bool m_areChildrenLoaded = false;
+
+    static inline std::vector<TreeParentNode*> s_loadingNodes; // UI thread only
+    static constexpr size_t c_appendsBetweenTimeChecks = 64;
+
 public:
     TreeParentNode() : TreeNode(TreeNodeType::Parent) {}
 
-    const std::vector<std::shared_ptr<TreeNode>>& GetNodes() const { return m_nodes; }
+    virtual ~TreeParentNode()
+    {
+        CancelLoading();
+    }
+
+    const std::vector<std::shared_ptr<TreeNode>>& GetNodes() const { return m_nodes.GetNodes(); }
 
     void SetExpandedIcon(const std::shared_ptr<UIElement>& sp) { m_spExpandedIcon = sp; }
     void SetOnExpandingOrCollapsing(std::function<void(TreeParentNode&, bool collapsing)>&& fn) { m_onExpandingOrCollapsing = std::move(fn); }
 
     virtual bool GetIsExpanded() const override { return m_isExpanded; }
 
+    // children come from fn, run on a worker thread the first time the node gets expanded;
+    // the node starts out collapsed
+    void SetChildrenProvider(TreeChildrenLoader::Provider&& fn)
+    {
+        CancelLoading();
+        SetIsExpanded(false);
+        m_childrenProvider = std::move(fn);
+        m_areChildrenLoaded = false;
+    }
+
+    // the row shown while children are loading, a "Loading..." leaf by default
+    void SetLoadingNode(const std::shared_ptr<TreeNode>& sp) { m_spLoadingNode = sp; }
+
+    bool IsLoadingChildren() const { return m_spLoader != nullptr; }
+
+    // drops the children so the provider runs again on the next expansion
+    void ReloadChildren()
+    {
+        CancelLoading();
+        RemoveAllNodes();
+        m_areChildrenLoaded = false;
+        if (m_isExpanded)
+            StartLoading();
+    }
+
     virtual void SetIsExpanded(bool value) override
     {
         if (value && m_onExpandingOrCollapsing)
             m_onExpandingOrCollapsing(*this, !value);
 
+        if (value && m_childrenProvider && !m_areChildrenLoaded)
+            StartLoading();
+        else if (!value && m_spLoader != nullptr)
+            CancelLoading(/*removeLoaded:*/ true);
+
+        if (m_isExpanded == value)
+            return;
+
+        m_measuredWidth = -1; // the icon changes with it
         m_isExpanded = value;
+
+        // only the children's totals get added or taken away, nothing below them is visited
+        const double height = m_nodes.GetMeasuredHeight();
+        const ptrdiff_t unmeasured = ptrdiff_t(m_nodes.GetUnmeasuredCount());
+        if (value)
+            OnSubtreeChanged(height, unmeasured);
+        else
+            OnSubtreeChanged(-height, -unmeasured);
     }
     
     virtual bool ToggleIsExpanded() override
@@ -37,27 +100,32 @@ public:
     }
 
     void AddNode(const std::shared_ptr<TreeNode>& spNode)
+    {
+        InsertNode(m_nodes.size(), spNode);
+    }
+
+    void InsertNode(size_t index, const std::shared_ptr<TreeNode>& spNode)
     {
         spNode->m_pParent = this;
-        m_nodes.push_back(spNode);
+        m_nodes.Insert(index, spNode);
     }
 
     bool RemoveNode(TreeNode* pNode)
     {
-        for (auto iter = m_nodes.begin(); iter != m_nodes.end(); iter++)
-        {
-            if (iter->get() == pNode)
-            {
-                m_nodes.erase(iter);
-                return true;
-            }
-        }
-        return false;
+        if (pNode->m_pList != &m_nodes)
+            return false;
+
+        // the list may hold the last reference
+        pNode->m_pParent = nullptr;
+        return m_nodes.Remove(pNode);
     }
 
     void RemoveAllNodes()
     {
-        m_nodes.clear();
+        for (const auto& spNode : m_nodes.GetNodes())
+            spNode->m_pParent = nullptr;
+
+        m_nodes.Clear();
     }
 
     size_t ChildCount()
@@ -65,7 +133,7 @@ public:
         return m_nodes.size();
     }
 
-    virtual v2_t Measure(float width, int32_t depth, float heightMultiplier, std::vector<TreeNode*>& visibleNodes) override
+    virtual v2_t Measure(float width, float heightMultiplier) override
     {
         m_iconWidth = 0;
         if (m_isExpanded && m_spExpandedIcon != nullptr)
@@ -75,31 +143,7 @@ public:
 
         width -= m_iconWidth;
 
-        v2_t bounds = TreeNode::Measure(width, depth, heightMultiplier, visibleNodes);
-        if (!m_isExpanded) return bounds;
-
-        for (const auto& spNode : m_nodes)
-        {
-            v2_t childSize = spNode->Measure(width, depth + 1, heightMultiplier, visibleNodes);
-            if (childSize.x > bounds.x)
-                bounds.x = childSize.x;
-
-            bounds.y += childSize.y;
-        }
-
-        return bounds;
-    }
-
-    virtual void UpdateVisuals(IRenderer& renderer) override
-    {
-        TreeNode::UpdateVisuals(renderer);
-
-        if (!m_isExpanded) return;
-
-        for (const auto& spNode : m_nodes)
-        {
-            spNode->UpdateVisuals(renderer);
-        }
+        return TreeNode::Measure(width, heightMultiplier);
     }
 
     virtual void DrawForeground(IRenderer& renderer, float x, float y, bool hover, bool selected) override
@@ -120,6 +164,99 @@ public:
 
         return TreeNode::DrawForeground(renderer, x, y, hover, selected);
     }
+
+    // UI thread: appends children loaded for this node until the deadline (Time::GetRealTime),
+    // returns whether the children changed
+    bool AppendLoadedChildren(time_t deadline)
+    {
+        size_t count = 0;
+        bool isFinished = false;
+        while (m_spLoader != nullptr)
+        {
+            if (m_appended == m_appending.size())
+            {
+                m_appending.clear();
+                m_appended = 0;
+
+                bool isComplete = false;
+                {
+                    std::lock_guard<std::mutex> lock(m_spLoader->m_mutex);
+                    std::swap(m_appending, m_spLoader->m_loaded);
+                    isComplete = m_spLoader->m_isComplete;
+                }
+
+                if (m_appending.empty())
+                {
+                    if (isComplete)
+                    {
+                        FinishLoading();
+                        isFinished = true;
+                    }
+                    break;
+                }
+            }
+
+            // the loading node stays last
+            InsertNode(m_nodes.size() - 1, m_appending[m_appended]);
+            m_appending[m_appended++] = nullptr;
+
+            if (++count % c_appendsBetweenTimeChecks == 0 && Time::GetRealTime() >= deadline)
+            {
+                FrameScheduler::RequestFrame();
+                break;
+            }
+        }
+
+        return count > 0 || isFinished;
+    }
+
+    static const std::vector<TreeParentNode*>& GetLoadingNodes() { return s_loadingNodes; }
+
+protected:
+    virtual TreeNodeList* GetChildren() override { return &m_nodes; }
+
+    void StartLoading()
+    {
+        if (m_spLoader != nullptr)
+            return;
+
+        if (m_spLoadingNode == nullptr)
+        {
+            m_spLoadingNode = std::make_shared<TreeLeafNode>();
+            m_spLoadingNode->SetText("Loading...");
+        }
+
+        AddNode(m_spLoadingNode);
+        m_spLoader = std::make_shared<TreeChildrenLoader>();
+        s_loadingNodes.push_back(this);
+
+        // the worker keeps its own references, the node may be gone before it finishes
+        TreeChildrenLoader::Run(m_spLoader, m_childrenProvider);
+    }
+
+    void FinishLoading()
+    {
+        RemoveNode(m_spLoadingNode.get());
+        std::erase(s_loadingNodes, this);
+        m_spLoader = nullptr;
+        m_areChildrenLoaded = true;
+    }
+
+    void CancelLoading(bool removeLoaded = false)
+    {
+        if (m_spLoader == nullptr)
+            return;
+
+        m_spLoader->m_isCancelled = true;
+        m_spLoader = nullptr;
+        m_appending.clear();
+        m_appended = 0;
+        std::erase(s_loadingNodes, this);
+
+        // partially loaded children are dropped, the next expansion starts over
+        if (removeLoaded)
+            RemoveAllNodes();
+    }
 };
 
 } // xpf
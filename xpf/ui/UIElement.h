@@ -1,10 +1,12 @@
 #pragma once
 #include <xpf/core/Color.h>
 #include <xpf/core/CornerRadius.h>
+#include <xpf/core/FrameScheduler.h>
 #include <xpf/core/Rectangle.h>
 #include <xpf/core/Time.h>
 #include <xpf/core/Thickness.h>
 #include <xpf/ui/AttachedProperty.h>
+#include <xpf/ui/LayoutManager.h>
 #include <xpf/ui/UIProperty.h>
 #include <xpf/ui/ThemeEngine.h>
 #include <xpf/renderer/RenderCommand.h>
@@ -28,6 +30,7 @@ enum class UIElementType
     TextBlock,
     TextBox,
     TreePanel,
+    VirtualizingStackPanel,
 };
 
 enum class HorizontalAlignment
@@ -84,6 +87,7 @@ protected:
     UIElement* m_pPrev = nullptr;
     bool m_layoutInvalidated = true;
     bool m_visualsInvalidated = true;
+    bool m_isLayoutQueued = false;
     bool m_clippingEnabled = false;
     bool m_pixel_perfect = false;
 
@@ -161,8 +165,18 @@ protected:
 
 public:
     void InvalidateParentLayout() { if (m_pParent != nullptr) { m_pParent->InvalidateLayout(); } InvalidateLayout(); }
-    void InvalidateLayout() { m_layoutInvalidated = m_visualsInvalidated = true;  }
-    void InvalidateVisuals() { m_visualsInvalidated = true; }
+    void InvalidateLayout()
+    {
+        m_layoutInvalidated = m_visualsInvalidated = true;
+
+        // every ancestor's cached measure may depend on this element's size
+        for (UIElement* pElement = this; pElement != nullptr; pElement = pElement->m_pParent)
+            pElement->m_measureInvalidated = true;
+
+        LayoutManager::Enqueue(this);
+        FrameScheduler::RequestFrame();
+    }
+    void InvalidateVisuals() { m_visualsInvalidated = true; FrameScheduler::RequestFrame(); }
     const rectf_t& GetActualRect() const { return m_marginRect; }
     v2_t GetDesiredSize() const { return m_desired_size; }
 
@@ -176,13 +190,20 @@ protected:
     v2_t m_assigned_size;
     v2_t m_desired_size;
     v2_t m_measure_outside_constraint;
+    v2_t m_measured_constraint; // constraint and result of the last measure, reused until layout is invalidated
+    v2_t m_measured_size;
+    bool m_measureInvalidated = true;
     rectf_t m_finalRect;
+    rectf_t m_arrangeRect; // what the parent last arranged this element into
+    bool m_isArranged = false;
     static inline bool m_rootArrangeSizeNeedsComputed = true;
     bool m_needsClipBounds = false;
     bool m_bypassLayoutPolicies = false;
 
 private:
-    void Layout(IRenderer& renderer)
+    friend class LayoutManager;
+
+    void ComputeRootConstraint()
     {
         if (m_pParent == nullptr && m_rootArrangeSizeNeedsComputed)
         {
@@ -191,8 +212,15 @@ private:
                 m_Width.ValueOr(800) - GetLeftRightThickness(),
                 m_Height.ValueOr(480) - GetTopBottomThickness() };
         }
+    }
 
-        if (m_layoutInvalidated)
+    void Layout(IRenderer& renderer)
+    {
+        ComputeRootConstraint();
+
+        // normally done by the LayoutManager already, left are elements that were never
+        // queued (e.g. added without invalidating their panel)
+        if (m_layoutInvalidated) [[unlikely]]
         {
             Measure(m_measure_outside_constraint);
             Arrange(m_finalRect);
@@ -204,6 +232,36 @@ private:
         }
     }
 
+    // lays out this element on its own, with the constraint and rect its parent last gave it
+    void LayoutFromQueue()
+    {
+        if (!m_layoutInvalidated)
+            return; // laid out along with an ancestor
+
+        if (m_pParent == nullptr)
+        {
+            ComputeRootConstraint();
+            Measure(m_measure_outside_constraint);
+            Arrange(m_finalRect);
+            return;
+        }
+
+        // never placed by its parent yet, Draw catches it if the parent does not
+        if (!m_isArranged)
+            return;
+
+        const v2_t desiredSize = m_desired_size;
+        Measure(m_measure_outside_constraint);
+        if (m_desired_size != desiredSize)
+        {
+            // the parent has to make room, it arranges this element again
+            m_pParent->InvalidateLayout();
+            return;
+        }
+
+        Arrange(m_arrangeRect);
+    }
+
 protected:
     float GetLeftRightThickness() const
     {
@@ -255,6 +313,22 @@ public:
     // outsideSize includes margin, border, padding thicknesses
     // computes desired size including margin, border, padding thicknesses
     v2_t Measure(v2_t outsideSize)
+    {
+        if (!m_measureInvalidated && outsideSize.x == m_measured_constraint.x && outsideSize.y == m_measured_constraint.y) [[likely]]
+        {
+            if (!m_bypassLayoutPolicies)
+                m_finalRect = {m_X, m_Y, m_desired_size.x, m_desired_size.y};
+            return m_measured_size;
+        }
+
+        m_measured_size = MeasureCore(outsideSize);
+        m_measured_constraint = outsideSize;
+        m_measureInvalidated = false;
+        return m_measured_size;
+    }
+
+protected:
+    v2_t MeasureCore(v2_t outsideSize)
     {
         m_measure_outside_constraint = outsideSize;
         if (m_bypassLayoutPolicies)
@@ -335,10 +409,13 @@ public:
         return desiredSize;
     }
 
+public:
     // finalRect includes, margin, border and padding
     void Arrange(rectf_t finalRect)
     {
-        m_visualsInvalidated = true;
+        InvalidateVisuals();
+        m_arrangeRect = finalRect;
+        m_isArranged = true;
         if (m_bypassLayoutPolicies)
         {
             // Size oldRenderSize = RenderSize;
@@ -544,6 +621,9 @@ public:
 public:
     void Draw(IRenderer& renderer)
     {
+        if (m_pParent == nullptr)
+            LayoutManager::Update();
+
         Layout(renderer);
 
         m4_t m = m4_t::translation_matrix(m_X, m_Y);
@@ -780,13 +860,17 @@ protected:
                 return false;
             }
 
+            bool pressed = false;
             if ((Time::GetTime() - m_time_KeyDown) > m_waitBeforeRepat)
             {
                 m_time_KeyDown = Time::GetTime();
                 m_waitBeforeRepat = .125;
-                return true;
+                pressed = true;
             }
-            return false;
+
+            // keep frames coming while the key is held so auto-repeat fires on time
+            FrameScheduler::RequestFrameAt(m_time_KeyDown + m_waitBeforeRepat);
+            return pressed;
         }
     };
 
@@ -810,6 +894,12 @@ public:
         : m_elementType(type)
     {}
 
+    virtual ~UIElement()
+    {
+        if (m_isLayoutQueued) [[unlikely]]
+            LayoutManager::Dequeue(this);
+    }
+
     UIElementType GetType() const { return m_elementType; }
 
     template<typename T> T* As() { return static_cast<T*>(this); }
@@ -825,7 +915,11 @@ void UIProperty<T>::Set(const T& f) {
 
     if (m_value != oldval || !m_isSet) {
         m_isSet = true;
-        m_onChanged(m_pOwner, m_value);
+        if (m_hasExtras) [[unlikely]] {
+            const auto& onChanged = GetExtras().onChanged;
+            if (onChanged != nullptr)
+                onChanged(m_pOwner, m_value);
+        }
         if (m_pOwner != nullptr) {
             switch (m_invalidates) {
                 case Invalidates::None:
@@ -844,4 +938,97 @@ void UIProperty<T>::Set(const T& f) {
     }
 }
 
+template<typename T>
+void UIProperty<T>::SetWithoutInvalidating(const T& f) {
+    if (!m_isReadOnly || (m_isSet && m_value == f))
+        return;
+
+    m_value = f;
+    m_isSet = true;
+    if (m_hasExtras) [[unlikely]] {
+        const auto& onChanged = GetExtras().onChanged;
+        if (onChanged != nullptr)
+            onChanged(m_pOwner, m_value);
+    }
+}
+
+inline void LayoutManager::Enqueue(UIElement* pElement)
+{
+    if (pElement->m_isLayoutQueued)
+        return;
+
+    pElement->m_isLayoutQueued = true;
+    if (!s_isUpdating) [[likely]]
+    {
+        s_queue.emplace_back(0, pElement); // depth is taken when the queue gets processed
+        return;
+    }
+
+    // only shallower elements join the running update, anything else waits for the next
+    // frame so that an element invalidating itself while laid out cannot loop forever
+    const uint32_t depth = GetDepth(pElement);
+    if (depth >= s_currentDepth)
+    {
+        s_deferred.emplace_back(depth, pElement);
+        return;
+    }
+
+    s_queue.emplace_back(depth, pElement);
+    std::push_heap(s_queue.begin(), s_queue.end(), IsDeeper);
+}
+
+inline void LayoutManager::Dequeue(UIElement* pElement)
+{
+    // entries are cleared rather than erased, the queue may be a heap right now
+    for (std::vector<QueueEntry>* pqueue : {&s_queue, &s_deferred})
+    {
+        for (QueueEntry& entry : *pqueue)
+        {
+            if (entry.second == pElement)
+                entry.second = nullptr;
+        }
+    }
+
+    pElement->m_isLayoutQueued = false;
+}
+
+inline uint32_t LayoutManager::GetDepth(const UIElement* pElement)
+{
+    uint32_t depth = 0;
+    for (const UIElement* pParent = pElement->m_pParent; pParent != nullptr; pParent = pParent->m_pParent)
+        depth++;
+    return depth;
+}
+
+inline void LayoutManager::Update()
+{
+    if (s_queue.empty()) [[likely]]
+        return;
+
+    // elements may have moved in the tree since they were queued
+    for (QueueEntry& entry : s_queue)
+    {
+        if (entry.second != nullptr)
+            entry.first = GetDepth(entry.second);
+    }
+
+    s_isUpdating = true;
+    std::make_heap(s_queue.begin(), s_queue.end(), IsDeeper);
+    while (!s_queue.empty())
+    {
+        std::pop_heap(s_queue.begin(), s_queue.end(), IsDeeper);
+        const QueueEntry entry = s_queue.back();
+        s_queue.pop_back();
+        if (entry.second == nullptr)
+            continue;
+
+        s_currentDepth = entry.first;
+        entry.second->m_isLayoutQueued = false;
+        entry.second->LayoutFromQueue();
+    }
+
+    s_isUpdating = false;
+    std::swap(s_queue, s_deferred);
+}
+
 } // xpf
@@ -1,12 +1,16 @@
 #pragma once
+#include <stdint.h>
 #include <functional>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
 #include <xpf/math/hash.h>
 
 namespace xpf {
 
 class UIElement;
 
-enum class Invalidates {
+enum class Invalidates : uint8_t {
     None,
     SelfLayout,
     ParentLayout,
@@ -15,22 +19,28 @@ enum class Invalidates {
 
 enum class ThemeId : uint32_t;
 
+// A property keeps its value, owner and flags inline. Getters, setters, change callbacks
+// and theme names are rare, they live in a side table keyed by the property's address.
 template<typename T>
 class UIProperty {
-public:
-    static inline std::function<void(UIElement*, T newValue)> NoopFn = [](UIElement*, T) {};
-
 protected:
+    struct Extras
+    {
+        std::function<T(T)> getter;
+        std::function<void(UIProperty<T>&)> setter;
+        std::function<void(UIElement*, T newValue)> onChanged;
+        std::string_view themeName;
+    };
+
     UIElement* m_pOwner = nullptr;
-    const Invalidates m_invalidates = Invalidates::Visuals;
     mutable T m_value = {};
-    bool m_isSet = false;
-    bool m_isReadOnly = true;
-    std::function<const T&(T)> m_getter;
-    std::function<void(UIProperty<T>&)> m_setter;
-    std::function<void(UIElement*, T newValue)> m_onChanged = NoopFn;
-    mutable ThemeId m_themeId = ThemeId(0);
-    std::string_view m_themeName;
+    const Invalidates m_invalidates = Invalidates::Visuals;
+    bool m_isSet : 1 = false;
+    bool m_isReadOnly : 1 = true;
+    bool m_hasExtras : 1 = false;
+    bool m_hasSource : 1 = false; // themed or with a getter, an unset value comes from the extras
+    bool m_hasGetter : 1 = false;
+    mutable uint8_t m_themeId = 0; // ThemeId the themed value was read for, a byte keeps the property small
 
 public:
     UIProperty() = default;
@@ -39,45 +49,71 @@ public:
         UIElement* p,
         T defaultValue = {},
         Invalidates invalidates = Invalidates::Visuals,
-        const std::function<void(UIElement*, T oldvalue)>& onChanged = NoopFn,
+        std::function<void(UIElement*, T newValue)>&& onChanged = nullptr,
         std::string_view name = "")
         : m_pOwner(p)
-        , m_invalidates(invalidates)
         , m_value(defaultValue)
-        , m_onChanged(onChanged)
-        , m_themeName(name)
-    {}
-
-    const T& Get() const
+        , m_invalidates(invalidates)
     {
-        if (m_isSet)
-            return m_value;
+        if (onChanged != nullptr)
+            GetOrAddExtras().onChanged = std::move(onChanged);
+        if (!name.empty())
+            SetThemeId(name);
+    }
 
-        TryGetValueFromThemeEngine();
+    UIProperty(const UIProperty& other)
+        : m_pOwner(other.m_pOwner)
+        , m_value(other.m_value)
+        , m_invalidates(other.m_invalidates)
+        , m_isSet(other.m_isSet)
+        , m_isReadOnly(other.m_isReadOnly)
+        , m_hasSource(other.m_hasSource)
+        , m_hasGetter(other.m_hasGetter)
+        , m_themeId(other.m_themeId)
+    {
+        if (other.m_hasExtras)
+            GetOrAddExtras() = other.GetExtras();
+    }
 
-        if (m_getter != nullptr)
+    ~UIProperty()
+    {
+        if (m_hasExtras)
         {
-            auto value = m_getter(m_value);
-            const_cast<UIProperty*>(this)->Set(value);
+            std::lock_guard<std::mutex> lock(ExtrasMutex());
+            ExtrasTable().erase(this);
         }
+    }
 
-        return m_value;
+    const T& Get() const
+    {
+        if (m_isSet || !m_hasSource) [[likely]]
+            return m_value;
+
+        return GetFromSource();
     }
 
-    void TryGetValueFromThemeEngine() const;
+    // themed values only go to the side table when the theme changed, defined in ThemeEngine.h
+    const T& GetFromSource() const;
 
     void Set(const T& f);
+    // for values the owner already accounted for, change callbacks still run
+    void SetWithoutInvalidating(const T& f);
     void SetDefaultValue(T f) { if (!m_isSet) { m_value = f; } }
     void Unset() { m_isSet = false; m_value = {}; }
     bool IsSet() const { return m_isSet; }
     void SetIsReadOnly(bool value) { m_isReadOnly = value; }
 
-    void SetThemeId(std::string_view name) { m_themeName = name; }
-    bool IsSetOrIsThemed() const { return m_isSet || !m_themeName.empty(); }
+    void SetThemeId(std::string_view name) { GetOrAddExtras().themeName = name; m_hasSource = true; }
+    bool IsSetOrIsThemed() const { return m_isSet || (m_hasExtras && !GetExtras().themeName.empty()); }
 
-    void SetGetter(std::function<T(T)>&& getter) { m_getter = std::move(getter); }
-    void SetSetter(std::function<void(UIProperty<T>&)>&& setter) { m_setter = std::move(setter); m_setter(*this); }
-    void SetOnChanged(std::function<void(UIElement*, T newValue)>&& onChanged) { m_onChanged = std::move(onChanged); }
+    void SetGetter(std::function<T(T)>&& getter) { GetOrAddExtras().getter = std::move(getter); m_hasSource = m_hasGetter = true; }
+    void SetSetter(std::function<void(UIProperty<T>&)>&& setter)
+    {
+        auto& extraSetter = GetOrAddExtras().setter;
+        extraSetter = std::move(setter);
+        extraSetter(*this);
+    }
+    void SetOnChanged(std::function<void(UIElement*, T newValue)>&& onChanged) { GetOrAddExtras().onChanged = std::move(onChanged); }
 
     const T& ValueOr(const T& v) { return m_isSet ? m_value : v; }
 
@@ -85,6 +121,36 @@ public:
     operator const T&() const { return Get(); }
     bool operator==(T t) const { return t == m_value; }
     bool operator!=(T t) const { return t != m_value; }
+
+protected:
+    // never destroyed, properties of elements in statics still erase their entry on exit
+    static std::unordered_map<const UIProperty*, Extras>& ExtrasTable()
+    {
+        static auto* s_pextras = new std::unordered_map<const UIProperty*, Extras>();
+        return *s_pextras;
+    }
+
+    // elements get built off the UI thread too (e.g. by TreeParentNode children providers), so
+    // the table is only touched under the lock; an entry is a node of its own, the reference
+    // handed out stays valid while other properties add or erase theirs
+    static std::mutex& ExtrasMutex()
+    {
+        static auto* s_pmutex = new std::mutex();
+        return *s_pmutex;
+    }
+
+    Extras& GetExtras() const
+    {
+        std::lock_guard<std::mutex> lock(ExtrasMutex());
+        return ExtrasTable().find(this)->second;
+    }
+
+    Extras& GetOrAddExtras()
+    {
+        m_hasExtras = true;
+        std::lock_guard<std::mutex> lock(ExtrasMutex());
+        return ExtrasTable()[this];
+    }
 };
 
 typedef std::function<void(UIProperty<float>&)> bind_float;
@@ -101,7 +167,7 @@ public: \
 
 #define DECLARE_THEMED_PROPERTY(TClass, TType, TName, TDefaultValue, TInvalidates) \
 protected: \
-    xpf::UIProperty<TType> m_##TName = {this, TDefaultValue, TInvalidates, xpf::UIProperty<TType>::NoopFn, #TClass "_" #TName}; \
+    xpf::UIProperty<TType> m_##TName = {this, TDefaultValue, TInvalidates, nullptr, #TClass "_" #TName}; \
 public: \
     TType Get##TName() const { return m_##TName.Get(); } \
     TClass& Set##TName(TType value) { m_##TName.Set(value); return *this; } \
@@ -0,0 +1,311 @@
+#pragma once
+#include <xpf/ui/UIElement.h>
+#include <xpf/ui/ScrollPanelMixIn.h>
+
+namespace xpf {
+
+// What a VirtualizingStackPanel shows: a number of items and the elements presenting them.
+// Containers get reused for other items as the panel scrolls, PrepareContainer has to set
+// up everything that differs between items.
+class VirtualItemsSource
+{
+public:
+    virtual ~VirtualItemsSource() = default;
+
+    virtual size_t GetCount() const = 0;
+    virtual std::shared_ptr<UIElement> CreateContainer() = 0;
+    virtual void PrepareContainer(UIElement& container, size_t index) = 0;
+};
+
+// Stacks the items of a VirtualItemsSource like a StackPanel, but only the items in the
+// viewport plus a few on either side have elements. Item positions and the content size
+// are estimated from the average extent of the items measured so far, so the cost of a
+// layout does not depend on the number of items.
+class VirtualizingStackPanel : public ScrollPanelMixIn<UIElement>
+{
+protected:
+    DECLARE_PROPERTY(VirtualizingStackPanel, xpf::Orientation, Orientation, Orientation::Vertical, Invalidates::ParentLayout);
+    DECLARE_PROPERTY(VirtualizingStackPanel, uint32_t, OverscanCount, 4, Invalidates::SelfLayout); // items realized beyond either side of the viewport
+
+    struct RealizedItem
+    {
+        size_t index;
+        float offset; // along the stacking direction, from the top/left of the content
+        std::shared_ptr<UIElement> spContainer;
+    };
+
+    std::shared_ptr<VirtualItemsSource> m_spSource;
+    std::vector<RealizedItem> m_realized;      // consecutive items, in order
+    std::vector<RealizedItem> m_lastRealized;  // scratch for OnMeasure, kept to reuse its storage
+    std::vector<std::shared_ptr<UIElement>> m_recycled;
+
+    // running average of the item extents, what unrealized items are assumed to be
+    double m_measuredExtent = 0;
+    size_t m_measuredCount = 0;
+    float m_maxCrossExtent = 0;
+
+    static constexpr float c_defaultItemExtent = 20;
+
+public:
+    VirtualizingStackPanel() : ScrollPanelMixIn(UIElementType::VirtualizingStackPanel)
+    {
+        m_clippingEnabled = true;
+    }
+
+    VirtualizingStackPanel& SetItemsSource(const std::shared_ptr<VirtualItemsSource>& spSource)
+    {
+        // containers came from the old source and may not fit the new one
+        m_spSource = spSource;
+        m_realized.clear();
+        m_recycled.clear();
+        ResetEstimate();
+        VerticalScrollTo(0);
+        HorizontalScrollTo(0);
+        InvalidateLayout();
+        return *this;
+    }
+
+    const std::shared_ptr<VirtualItemsSource>& GetItemsSource() const { return m_spSource; }
+
+    // the items changed, realized containers get prepared again
+    void ItemsChanged()
+    {
+        for (RealizedItem& item : m_realized)
+            m_recycled.push_back(std::move(item.spContainer));
+        m_realized.clear();
+        InvalidateLayout();
+    }
+
+    float GetAverageItemExtent() const
+    {
+        return m_measuredCount > 0 ? float(m_measuredExtent / m_measuredCount) : c_defaultItemExtent;
+    }
+
+protected:
+    void ResetEstimate()
+    {
+        m_measuredExtent = 0;
+        m_measuredCount = 0;
+        m_maxCrossExtent = 0;
+    }
+
+    std::shared_ptr<UIElement> Realize(size_t index)
+    {
+        // reuse the container when the item stays realized
+        for (RealizedItem& item : m_lastRealized)
+        {
+            if (item.index == index && item.spContainer != nullptr)
+                return std::move(item.spContainer);
+        }
+
+        std::shared_ptr<UIElement> spContainer;
+        if (!m_recycled.empty())
+        {
+            spContainer = std::move(m_recycled.back());
+            m_recycled.pop_back();
+        }
+        else
+        {
+            spContainer = m_spSource->CreateContainer();
+            AddVisual(spContainer.get());
+        }
+
+        m_spSource->PrepareContainer(*spContainer, index);
+        return spContainer;
+    }
+
+#pragma region measure & arrange
+public:
+    virtual v2_t OnMeasure(v2_t insideSize) override
+    {
+        std::swap(m_realized, m_lastRealized);
+        m_realized.clear();
+
+        const size_t count = m_spSource != nullptr ? m_spSource->GetCount() : 0;
+        if (count == 0)
+        {
+            for (RealizedItem& item : m_lastRealized)
+                m_recycled.push_back(std::move(item.spContainer));
+            m_lastRealized.clear();
+            ResetEstimate();
+            m_ContentSize.Set(v2_t(0, 0));
+            return m_ContentSize;
+        }
+
+        const bool isVertical = (m_Orientation == Orientation::Vertical);
+        const float viewportStart = isVertical ? m_VerticalScrollPosition : m_HorizontalScrollPosition;
+        const float viewportExtent = isVertical ? insideSize.h : insideSize.w;
+        const size_t overscan = m_OverscanCount;
+
+        auto measure = [&](size_t index) -> v2_t
+        {
+            bool isNew = true;
+            for (const RealizedItem& item : m_lastRealized)
+                isNew &= (item.index != index);
+
+            std::shared_ptr<UIElement> spContainer = Realize(index);
+            v2_t desiredSize = spContainer->Measure(insideSize);
+            if (isVertical && spContainer->GetHorizontalAlignment() == HorizontalAlignment::Stretch)
+                desiredSize.x = insideSize.w;
+            else if (!isVertical && spContainer->GetVerticalAlignment() == VerticalAlignment::Stretch)
+                desiredSize.y = insideSize.h;
+
+            const float extent = isVertical ? desiredSize.y : desiredSize.x;
+            if (isNew)
+            {
+                m_measuredExtent += extent;
+                m_measuredCount++;
+            }
+
+            m_maxCrossExtent = std::max(m_maxCrossExtent, isVertical ? desiredSize.x : desiredSize.y);
+            m_realized.push_back({index, 0, std::move(spContainer)});
+            return desiredSize;
+        };
+
+        // the first visible item is where the estimate puts it, the others stack from there
+        const float average = GetAverageItemExtent();
+        const size_t first = std::min(size_t(std::max(0.0f, viewportStart) / average), count - 1);
+        const float firstOffset = first * average;
+
+        const float viewportEnd = viewportStart + viewportExtent;
+        float offset = firstOffset;
+        size_t index = first;
+        for (size_t beyond = 0; index < count; index++)
+        {
+            if (index > first && offset >= viewportEnd && beyond++ == overscan)
+                break;
+
+            const v2_t desiredSize = measure(index);
+            m_realized.back().offset = offset;
+            offset += isVertical ? desiredSize.y : desiredSize.x;
+        }
+        const float endOffset = offset;
+
+        // items before the first visible one, stacked backwards
+        const size_t start = first > overscan ? first - overscan : 0;
+        const size_t after = m_realized.size();
+        offset = firstOffset;
+        for (size_t i = first; i > start; i--)
+        {
+            const v2_t desiredSize = measure(i - 1);
+            offset -= isVertical ? desiredSize.y : desiredSize.x;
+            m_realized.back().offset = offset;
+        }
+        std::reverse(m_realized.begin() + after, m_realized.end());
+        std::rotate(m_realized.begin(), m_realized.begin() + after, m_realized.end());
+
+        // near the top the estimate gets corrected, the first item always starts at 0
+        const float correction = (start == 0) ? -m_realized.front().offset : 0;
+        if (correction != 0)
+        {
+            for (RealizedItem& item : m_realized)
+                item.offset += correction;
+        }
+
+        // whatever scrolled out of range is kept for the items scrolling in next
+        for (RealizedItem& item : m_lastRealized)
+        {
+            if (item.spContainer != nullptr)
+                m_recycled.push_back(std::move(item.spContainer));
+        }
+        m_lastRealized.clear();
+
+        // the last item has to be reachable even when the items before it were above average
+        float contentExtent = float(count * GetAverageItemExtent());
+        if (index == count)
+            contentExtent = std::max(contentExtent, endOffset + correction);
+        m_ContentSize.Set(isVertical ? v2_t(m_maxCrossExtent, contentExtent) : v2_t(contentExtent, m_maxCrossExtent));
+        return m_ContentSize;
+    }
+
+    virtual void OnArrange(v2_t insideSize) override
+    {
+        float insideWidth = insideSize.w;
+        float insideHeight = insideSize.h;
+
+        if (!m_OverlayScrollbarsOverContent)
+        {
+            if (m_ShowHorizontalScrollbar)
+                insideHeight -= m_ScrollbarWidth;
+
+            if (m_ShowVerticalScrollbar)
+                insideWidth -= m_ScrollbarWidth;
+        }
+
+        const bool isVertical = (m_Orientation == Orientation::Vertical);
+        for (const RealizedItem& item : m_realized)
+        {
+            UIElement& container = *item.spContainer;
+            float left = m_insideRect.x, top = m_insideRect.y;
+            const v2_t childSize = container.GetDesiredSize();
+            float w = childSize.x;
+            float h = childSize.y;
+
+            if (isVertical)
+            {
+                top += item.offset;
+                switch (container.GetHorizontalAlignment())
+                {
+                    case HorizontalAlignment::Left: break;
+                    case HorizontalAlignment::Center: left += (insideWidth - w) * .5; break;
+                    case HorizontalAlignment::Right: left += insideWidth - w; break;
+                    case HorizontalAlignment::Stretch: w = insideWidth; break;
+                }
+            }
+            else
+            {
+                left += item.offset;
+                switch (container.GetVerticalAlignment())
+                {
+                    case VerticalAlignment::Top: break;
+                    case VerticalAlignment::Center: top += (insideHeight - h) * .5; break;
+                    case VerticalAlignment::Bottom: top += insideHeight - h; break;
+                    case VerticalAlignment::Stretch: h = insideHeight; break;
+                }
+            }
+
+            container.Arrange({left, top, w, h});
+        }
+
+        m_ViewPortSize.Set(m_insideRect.size());
+        ArrangeScrollbars(m_insideRect);
+    }
+#pragma endregion
+
+#pragma region drawing
+    virtual void OnUpdateVisuals(IRenderer& renderer) override
+    {
+        for (const RealizedItem& item : m_realized)
+            item.spContainer->UpdateVisuals(renderer);
+
+        ScrollPanelMixIn<UIElement>::OnUpdateVisuals(renderer);
+    }
+
+    virtual void OnDraw(IRenderer& renderer) override
+    {
+        {
+            auto scope = renderer.TranslateTransfrom(-std::floor(m_HorizontalScrollPosition), -std::floor(m_VerticalScrollPosition));
+            for (const RealizedItem& item : m_realized)
+                item.spContainer->Draw(renderer);
+        }
+
+        DrawScrollbars(renderer);
+    }
+#pragma endregion
+
+protected:
+    virtual void OnMouse(bool is_inside) override
+    {
+        if (is_inside && m_ScrollOptions != ScrollOptions::NoScroll)
+        {
+            if (m_Orientation == Orientation::Vertical)
+                VerticalScrollbarMouseWheelHandler();
+            else
+                HorizontalScrollbarMouseWheelHandler();
+        }
+
+        UIElement::OnMouse(is_inside);
+    }
+};
+
+} // xpf